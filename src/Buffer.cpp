@@ -68,6 +68,24 @@ Buffer::Buffer(uint64_t i){
     sendingDie = 0;
     sendingPlane = 0;
 
+    num_dies = DIES_PER_PACKAGE;
+    page_bits = NV_PAGE_SIZE*8192;
+    command_length = COMMAND_LENGTH;
+    device_width = DEVICE_WIDTH;
+    channel_width = CHANNEL_WIDTH;
+    in_buffer_size = IN_BUFFER_SIZE;
+    out_buffer_size = OUT_BUFFER_SIZE;
+    device_cycles = divide_params(DEVICE_CYCLE,CYCLE_TIME);
+}
+
+Buffer::~Buffer(void){
+    delete [] outDataSize;
+    delete [] inDataSize;
+    delete [] cyclesLeft;
+    delete [] outDataLeft;
+    delete [] critData;
+    delete [] inDataLeft;
+    delete [] waiting;
 }
 
 void Buffer::attachDie(Die *d){
@@ -89,28 +107,28 @@ void Buffer::sendToController(ChannelPacket *busPacket){
 bool Buffer::sendPiece(SenderType t, uint type, uint64_t die, uint64_t plane){
     if(t == CONTROLLER)
     {
-	if(IN_BUFFER_SIZE == 0 || inDataSize[die] <= (IN_BUFFER_SIZE-(CHANNEL_WIDTH)))
+	if(in_buffer_size == 0 || inDataSize[die] <= (in_buffer_size-(channel_width)))
 	{
 	    if(!inData[die].empty() && inData[die].back()->type == type && inData[die].back()->plane == plane &&
-	       type == 5 && inData[die].back()->number < (NV_PAGE_SIZE*8192))
+	       type == 5 && inData[die].back()->number < page_bits)
 	    {
-		inData[die].back()->number = inData[die].back()->number + CHANNEL_WIDTH;
-		inDataSize[die] = inDataSize[die] + CHANNEL_WIDTH;
+		inData[die].back()->number = inData[die].back()->number + channel_width;
+		inDataSize[die] = inDataSize[die] + channel_width;
 	    }
 	    else if(!inData[die].empty() && inData[die].back()->type == type && inData[die].back()->plane == plane && 
-		    type != 5 && inData[die].back()->number < COMMAND_LENGTH)
+		    type != 5 && inData[die].back()->number < command_length)
 	    {
-		inData[die].back()->number = inData[die].back()->number + CHANNEL_WIDTH;
-		inDataSize[die] = inDataSize[die] + CHANNEL_WIDTH;
+		inData[die].back()->number = inData[die].back()->number + channel_width;
+		inDataSize[die] = inDataSize[die] + channel_width;
 	    }
 	    else
 	    {	
-		BufferPacket* myPacket = new BufferPacket();
+		BufferPacket* myPacket = packetPool.get();
 		myPacket->type = type;
-		myPacket->number = CHANNEL_WIDTH;
+		myPacket->number = channel_width;
 		myPacket->plane = plane;
 		inData[die].push_back(myPacket);
-		inDataSize[die] = inDataSize[die] + CHANNEL_WIDTH;
+		inDataSize[die] = inDataSize[die] + channel_width;
 	    }
 	    return true;
 	}
@@ -121,24 +139,24 @@ bool Buffer::sendPiece(SenderType t, uint type, uint64_t die, uint64_t plane){
     }
     else if(t == BUFFER)
     {
-	if(OUT_BUFFER_SIZE == 0 || outDataSize[die] <= (OUT_BUFFER_SIZE-DEVICE_WIDTH))
+	if(out_buffer_size == 0 || outDataSize[die] <= (out_buffer_size-device_width))
 	{
 	    if(!outData[die].empty() && outData[die].back()->type == type && outData[die].back()->plane == plane &&
-	       outData[die].back()->number < (NV_PAGE_SIZE*8192)){
-		outData[die].back()->number = outData[die].back()->number + DEVICE_WIDTH;
-		outDataSize[die] = outDataSize[die] + DEVICE_WIDTH;
+	       outData[die].back()->number < page_bits){
+		outData[die].back()->number = outData[die].back()->number + device_width;
+		outDataSize[die] = outDataSize[die] + device_width;
 		// if ths was the last piece of this packet, tell the die
-		if( outData[die].back()->number >= (NV_PAGE_SIZE*8192))
+		if( outData[die].back()->number >= page_bits)
 		{
 		    dies[die]->bufferLoaded();
 		}
 	    }else{
-		BufferPacket* myPacket = new BufferPacket();
+		BufferPacket* myPacket = packetPool.get();
 		myPacket->type = type;
-		myPacket->number = DEVICE_WIDTH;
+		myPacket->number = device_width;
 		myPacket->plane = plane;
 		outData[die].push_back(myPacket);
-		outDataSize[die] = outDataSize[die] + DEVICE_WIDTH;
+		outDataSize[die] = outDataSize[die] + device_width;
 	    }
 	    return true;
 	}
@@ -154,7 +172,7 @@ bool Buffer::isFull(SenderType t, uint64_t die)
 {
     if(t == CONTROLLER)
     {
-	if(IN_BUFFER_SIZE == 0 || inDataSize[die] <= (IN_BUFFER_SIZE-(CHANNEL_WIDTH)))
+	if(in_buffer_size == 0 || inDataSize[die] <= (in_buffer_size-(channel_width)))
 	{
 	    return false;
 	}
@@ -165,7 +183,7 @@ bool Buffer::isFull(SenderType t, uint64_t die)
     }
     else if(t == BUFFER)
     {
-	if(OUT_BUFFER_SIZE == 0 || outDataSize[die] <= (OUT_BUFFER_SIZE-DEVICE_WIDTH))
+	if(out_buffer_size == 0 || outDataSize[die] <= (out_buffer_size-device_width))
 	{
 	    return false;
 	}
@@ -178,7 +196,7 @@ bool Buffer::isFull(SenderType t, uint64_t die)
 }
 	    
 void Buffer::update(void){
-    for(uint64_t i = 0; i < DIES_PER_PACKAGE; i++){
+    for(uint64_t i = 0; i < num_dies; i++){
 	// moving data into a die
 	//==================================================================================
 	// if we're not already busy writing stuff
@@ -190,34 +208,34 @@ void Buffer::update(void){
 	    if(inData[i].front()->type != 5)
 	    {
 		// first time we've dealt with this command so we need to set our values
-		if(inDataLeft[i] == 0 && waiting[i] != true && inData[i].front()->number >= COMMAND_LENGTH)
+		if(inDataLeft[i] == 0 && waiting[i] != true && inData[i].front()->number >= command_length)
 		{
-		    inDataLeft[i] = COMMAND_LENGTH;
-		    cyclesLeft[i] = divide_params(DEVICE_CYCLE,CYCLE_TIME);
+		    inDataLeft[i] = command_length;
+		    cyclesLeft[i] = device_cycles;
 		    processInData(i);
 		}
 		// need to make sure either enough data has been transfered to the buffer to warrant
 		// sending out more data or all of the data for this particular packet has already
 		// been loaded into the buffer
-		else if(inData[i].front()->number >= ((COMMAND_LENGTH-inDataLeft[i])+DEVICE_WIDTH) ||
-			(inData[i].front()->number >= COMMAND_LENGTH))
+		else if(inData[i].front()->number >= ((command_length-inDataLeft[i])+device_width) ||
+			(inData[i].front()->number >= command_length))
 		{
 		    processInData(i);
 		}
 	    }
 	    // its not a command but it is the first time we've dealt with this data
-	    else if(inDataLeft[i] == 0 && waiting[i] != true && inData[i].front()->number >= DEVICE_WIDTH)
+	    else if(inDataLeft[i] == 0 && waiting[i] != true && inData[i].front()->number >= device_width)
 	    {
-		inDataLeft[i] = (NV_PAGE_SIZE*8192);
-		cyclesLeft[i] = divide_params(DEVICE_CYCLE,CYCLE_TIME);
+		inDataLeft[i] = page_bits;
+		cyclesLeft[i] = device_cycles;
 		processInData(i);
 	    }
 	    // its not a command and its not the first time we've seen it but we still need to make sure either
 	    // there is enough data to warrant sending out the data or all of the data for this particular packet has already
 	    // been loaded into the buffer
 	    
-	    else if (inData[i].front()->number >= (((NV_PAGE_SIZE*8192)-inDataLeft[i])+DEVICE_WIDTH) ||
-		     (inData[i].front()->number >= (NV_PAGE_SIZE*8192)))
+	    else if (inData[i].front()->number >= ((page_bits-inDataLeft[i])+device_width) ||
+		     (inData[i].front()->number >= page_bits))
 	    {
 		processInData(i);
 	    }
@@ -228,20 +246,20 @@ void Buffer::update(void){
 	// first scan through to see if we have stuff to send if we're not busy
 	if(!outData[i].empty())
 	{
-	    if(outData[i].front()->number >= CHANNEL_WIDTH)
+	    if(outData[i].front()->number >= channel_width)
 	    {
 		//cout << "buffer tried to get the channel \n";
 		// then see if we have control of the channel
 		if (channel->hasChannel(BUFFER, id) && sendingDie == i && sendingPlane == outData[i].front()->plane)
 		{
-		    if((outData[i].front()->number >= (((NV_PAGE_SIZE*8192)-outDataLeft[i])+CHANNEL_WIDTH)) ||
-		       (outData[i].front()->number >= (NV_PAGE_SIZE*8192)))
+		    if((outData[i].front()->number >= ((page_bits-outDataLeft[i])+channel_width)) ||
+		       (outData[i].front()->number >= page_bits))
 		    {
 			processOutData(i);
 		    }
 		}
 		else if (channel->obtainChannel(id, BUFFER, NULL)){
-		    outDataLeft[i] = (NV_PAGE_SIZE*8192);
+		    outDataLeft[i] = page_bits;
 		    sendingDie = i;
 		    sendingPlane = outData[i].front()->plane;
 		    processOutData(i);
@@ -251,6 +269,17 @@ void Buffer::update(void){
     }
 }
 
+// the buffer has nothing to do until data shows up on either side of it
+uint64_t Buffer::nextEvent(void){
+    for(uint64_t i = 0; i < num_dies; i++){
+	if(!inData[i].empty() || !outData[i].empty())
+	{
+	    return 0;
+	}
+    }
+    return NO_EVENT;
+}
+
 void Buffer::processInData(uint64_t die){
 
     // count down the time it takes for the device to latch the data
@@ -266,13 +295,13 @@ void Buffer::processInData(uint64_t die){
 	if(inDataLeft[die] > 0)
 	{
 	    // set the device latching cycle for this next piece of data
-	    cyclesLeft[die] = divide_params(DEVICE_CYCLE,CYCLE_TIME);
+	    cyclesLeft[die] = device_cycles;
 	    // subtract this chunk of data from the data we need to send to be done
-	    if(inDataLeft[die] >= DEVICE_WIDTH)
+	    if(inDataLeft[die] >= device_width)
 	    {
 		//cout << "sending data to die \n";
-		inDataLeft[die] = inDataLeft[die] - DEVICE_WIDTH;
-		inDataSize[die] = inDataSize[die] - DEVICE_WIDTH;
+		inDataLeft[die] = inDataLeft[die] - device_width;
+		inDataSize[die] = inDataSize[die] - device_width;
 	    }
 	    // if we only had a tiny amount left to send just set remaining count to zero
 	    // to avoid negative numbers here which break things
@@ -290,6 +319,7 @@ void Buffer::processInData(uint64_t die){
 	if(!dies[die]->isDieBusy(inData[die].front()->plane))
 	{   
 	    channel->bufferDone(id, die, inData[die].front()->plane);
+	    packetPool.put(inData[die].front());
 	    inData[die].pop_front();
 	    waiting[die] = false;
 	}
@@ -302,7 +332,7 @@ void Buffer::processInData(uint64_t die){
 
 void Buffer::processOutData(uint64_t die){
     // deal with the critical line first stuff first
-    if(critData[die] >= 512 && critData[die] < 512+CHANNEL_WIDTH && channel->notBusy())
+    if(critData[die] >= 512 && critData[die] < 512+channel_width && channel->notBusy())
     {
 	dies[die]->critLineDone();
     }
@@ -311,17 +341,17 @@ void Buffer::processOutData(uint64_t die){
     if(outDataLeft[die] > 0 && channel->notBusy()){
 	channel->sendPiece(BUFFER,outData[die].front()->type,die,outData[die].front()->plane);
 	
-	if(outDataLeft[die] >= CHANNEL_WIDTH)
+	if(outDataLeft[die] >= channel_width)
 	{
-	    outDataLeft[die] = outDataLeft[die] - CHANNEL_WIDTH;
-	    outDataSize[die] = outDataSize[die] - CHANNEL_WIDTH;
+	    outDataLeft[die] = outDataLeft[die] - channel_width;
+	    outDataSize[die] = outDataSize[die] - channel_width;
 	}
 	else
 	{
 	    outDataSize[die] = outDataSize[die] - outDataLeft[die];
 	    outDataLeft[die] = 0;
 	}
-	critData[die] = critData[die] + CHANNEL_WIDTH;
+	critData[die] = critData[die] + channel_width;
     }
     
     // we're done here
@@ -330,6 +360,7 @@ void Buffer::processOutData(uint64_t die){
 	dies[die]->bufferDone(outData[die].front()->plane);
 	channel->releaseChannel(BUFFER,id);
 	critData[die] = 0;
+	packetPool.put(outData[die].front());
 	outData[die].pop_front();
     }
 }
@@ -41,11 +41,13 @@
 #include "ChannelPacket.h"
 #include "Die.h"
 #include "Channel.h"
+#include "ObjectPool.h"
 
 namespace NVDSim{
     class Buffer : public SimObj{
         public:
 	    Buffer(uint64_t i);
+	    ~Buffer(void);
 	    void attachDie(Die *d);
 	    void attachChannel(Channel *c);
 	    void sendToDie(ChannelPacket *busPacket);
@@ -55,6 +57,7 @@ namespace NVDSim{
 	    bool isFull(SenderType t, uint64_t die);
 	    
 	    void update(void);
+	    uint64_t nextEvent(void);
 
 	    void processInData(uint64_t die);
 	    void processOutData(uint64_t die);
@@ -95,6 +98,16 @@ namespace NVDSim{
 	    std::vector<std::list<BufferPacket *> >  outData;
 	    uint64_t* inDataSize;
 	    std::vector<std::list<BufferPacket *> > inData;
+
+	    ObjectPool<BufferPacket> packetPool;
+
+	    // config values used on every update, copied in when the buffer is built
+	    uint64_t num_dies;
+	    uint64_t page_bits; // NV_PAGE_SIZE is in KB
+	    uint command_length;
+	    uint64_t device_width, channel_width;
+	    uint64_t in_buffer_size, out_buffer_size;
+	    uint device_cycles;
     };
 } 
 
@@ -123,6 +123,14 @@ void Channel::update(void){
 	}
 }
 
+// the channel only does work on its own while a piece is in flight
+uint64_t Channel::nextEvent(void){
+        if(busy == 1){
+	    return 0;
+	}
+	return NO_EVENT;
+}
+
 void Channel::bufferDone(uint64_t package, uint64_t die, uint64_t plane){
     controller->bufferDone(package, die, plane);
 }
@@ -63,6 +63,7 @@ namespace NVDSim{
 			int notBusy(void);
 
 			void update(void);
+			uint64_t nextEvent(void);
 
 			void bufferDone(uint64_t package, uint64_t die, uint64_t plane);
 			
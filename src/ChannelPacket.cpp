@@ -39,8 +39,9 @@
 using namespace NVDSim;
 using namespace std;
 
-ChannelPacket::ChannelPacket(ChannelPacketType packtype, uint64_t virtualAddr, uint64_t physicalAddr, uint page_num, uint block_num, uint plane_num, uint die_num, uint package_num, void *dat)
+ChannelPacket::ChannelPacket(ChannelPacketType packtype, uint64_t packetId, uint64_t virtualAddr, uint64_t physicalAddr, uint page_num, uint block_num, uint plane_num, uint die_num, uint package_num, void *dat)
 {
+        id = packetId;
         virtualAddress = virtualAddr;
 	physicalAddress = physicalAddr;
 	busPacketType = packtype;
@@ -58,7 +59,7 @@ void ChannelPacket::print(uint64_t currentClockCycle){
 	if (this == NULL)
 		return;
 
-	PRINT("Cycle: "<<currentClockCycle<<" Type: " << busPacketType << " addr: "<<physicalAddress<<" die: "<<die<<" plane: "<<
+	PRINT("Cycle: "<<currentClockCycle<<" Type: " << busPacketType << " id: "<<id<<" addr: "<<physicalAddress<<" die: "<<die<<" plane: "<<
 			plane<<" block: "<<block<<" page: "<<page<<" data: "<<data);
 }
 
@@ -63,12 +63,13 @@ namespace NVDSim
 		uint plane;
 		uint die;
 		uint package;
+		uint64_t id; // the request this packet is part of
 		uint64_t virtualAddress;
 		uint64_t physicalAddress;
 		void *data;
 
 		//Functions
-		ChannelPacket(ChannelPacketType packtype, uint64_t virtualAddr, uint64_t physicalAddr, uint page, uint block, uint plane, uint die, uint package, void *dat);
+		ChannelPacket(ChannelPacketType packtype, uint64_t id, uint64_t virtualAddr, uint64_t physicalAddr, uint page, uint block, uint plane, uint die, uint package, void *dat);
 		ChannelPacket();
 
 		//void print();
@@ -0,0 +1,189 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//Checkpoint.cpp
+//class file for the binary nv state checkpoint
+//
+#include "Checkpoint.h"
+#include <fstream>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace NVDSim;
+using namespace std;
+
+Checkpoint::Checkpoint(void){
+	base = NULL;
+	length = 0;
+	header = NULL;
+}
+
+Checkpoint::~Checkpoint(void){
+	if (base != NULL)
+		munmap((void *) base, length);
+}
+
+bool Checkpoint::isCheckpoint(string filename){
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	ifstream file;
+
+	file.open(filename.c_str(), ios_base::in | ios_base::binary);
+	if (!file)
+		return false;
+
+	file.read(magic, sizeof(magic));
+	return file.gcount() == sizeof(magic) && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0;
+}
+
+void Checkpoint::save(string filename, MappingTable &map, PageBitmap &used, PageBitmap *dirty){
+	CheckpointHeader h;
+	ofstream file;
+	uint64_t pair[2];
+	unordered_map<uint64_t, uint64_t>::const_iterator it;
+	const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	h.version = CHECKPOINT_VERSION;
+	h.flags = (dirty != NULL) ? CHECKPOINT_HAS_DIRTY : 0;
+	h.byte_order = CHECKPOINT_BYTE_ORDER;
+
+	h.total_size = TOTAL_SIZE;
+	h.virtual_total_size = VIRTUAL_TOTAL_SIZE;
+	h.page_size = NV_PAGE_SIZE;
+	h.blocks = used.blocks();
+	h.pages_per_block = used.pages();
+
+	h.map_entry_bytes = map.entryBytes();
+	h.map_pages = map.pages();
+	h.unaligned_entries = map.unalignedEntries().size();
+	h.bitmap_words = used.data_words();
+
+	layout(&h);
+
+	file.open(filename.c_str(), ios_base::out | ios_base::trunc | ios_base::binary);
+	if (!file)
+	{
+		cout << "ERROR: Could not open NVDIMM state save file: " << filename << "\n";
+		abort();
+	}
+
+	file.write((const char *) &h, sizeof(h));
+	file.write(zeros, h.map_offset - sizeof(h));
+	file.write((const char *) map.entries(), h.map_pages * h.map_entry_bytes);
+	file.write(zeros, h.unaligned_offset - (h.map_offset + h.map_pages * h.map_entry_bytes));
+	for (it = map.unalignedEntries().begin(); it != map.unalignedEntries().end(); it++)
+	{
+		pair[0] = (*it).first;
+		pair[1] = (*it).second;
+		file.write((const char *) pair, sizeof(pair));
+	}
+	file.write((const char *) used.data(), h.bitmap_words * sizeof(uint64_t));
+	if (dirty != NULL)
+		file.write((const char *) dirty->data(), h.bitmap_words * sizeof(uint64_t));
+
+	if (!file)
+	{
+		cout << "ERROR: Could not write NVDIMM state save file: " << filename << "\n";
+		abort();
+	}
+	file.close();
+}
+
+void Checkpoint::layout(CheckpointHeader *h){
+	h->map_offset = align(sizeof(CheckpointHeader));
+	h->unaligned_offset = align(h->map_offset + h->map_pages * h->map_entry_bytes);
+	h->used_offset = h->unaligned_offset + h->unaligned_entries * 2 * sizeof(uint64_t);
+	h->dirty_offset = h->used_offset + h->bitmap_words * sizeof(uint64_t);
+	h->file_size = h->dirty_offset + ((h->flags & CHECKPOINT_HAS_DIRTY) ? h->bitmap_words * sizeof(uint64_t) : 0);
+}
+
+void Checkpoint::open(string filename, const MappingTable &map, const PageBitmap &used){
+	CheckpointHeader expected;
+	struct stat st;
+	void *mapped;
+	int fd;
+
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		cout << "ERROR: Could not open NVDIMM restore file: " << filename << "\n";
+		abort();
+	}
+
+	if ((uint64_t) st.st_size < sizeof(CheckpointHeader))
+	{
+		ERROR("NVDIMM restore file "<<filename<<" is too short to be a checkpoint");
+		abort();
+	}
+
+	length = st.st_size;
+	mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		ERROR("Could not map NVDIMM restore file "<<filename);
+		abort();
+	}
+	base = (const char *) mapped;
+	header = (const CheckpointHeader *) base;
+
+	if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || header->byte_order != CHECKPOINT_BYTE_ORDER)
+	{
+		ERROR("NVDIMM restore file "<<filename<<" is not a checkpoint written on this kind of machine");
+		abort();
+	}
+	if (header->version != CHECKPOINT_VERSION)
+	{
+		ERROR("NVDIMM restore file "<<filename<<" is checkpoint version "<<header->version<<", this simulator reads version "<<CHECKPOINT_VERSION);
+		abort();
+	}
+	if (header->total_size != TOTAL_SIZE || header->virtual_total_size != VIRTUAL_TOTAL_SIZE || header->page_size != NV_PAGE_SIZE ||
+	    header->blocks != used.blocks() || header->pages_per_block != used.pages() || header->bitmap_words != used.data_words() ||
+	    header->map_pages != map.pages() || header->map_entry_bytes != map.entryBytes())
+	{
+		ERROR("NVDIMM restore file "<<filename<<" was saved from a device with a different geometry");
+		abort();
+	}
+
+	expected = *header;
+	layout(&expected);
+	if (memcmp(&expected, header, sizeof(CheckpointHeader)) != 0 || header->file_size != length)
+	{
+		ERROR("NVDIMM restore file "<<filename<<" is truncated or corrupt");
+		abort();
+	}
+}
@@ -0,0 +1,120 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVCHECKPOINT_H
+#define NVCHECKPOINT_H
+//Checkpoint.h
+//header file for the binary nv state checkpoint
+
+#include <string>
+#include <stdint.h>
+#include "FlashConfiguration.h"
+#include "MappingTable.h"
+#include "PageBitmap.h"
+
+#define CHECKPOINT_MAGIC "NVDCKPT"
+#define CHECKPOINT_VERSION 1
+// written as a native integer so a checkpoint from a machine with the other byte order is caught
+#define CHECKPOINT_BYTE_ORDER 0x0102030405060708ULL
+
+// flags
+#define CHECKPOINT_HAS_DIRTY 0x1
+
+namespace NVDSim{
+	// Everything the ftl needs to come back up, laid out so the sections can be copied straight out of a
+	// mapped file. The header records the geometry the checkpoint was taken with and where each section
+	// starts, every section starts on an 8 byte boundary.
+	//
+	//    header
+	//    address map entries (4 or 8 bytes per virtual page, the same as in the MappingTable)
+	//    unaligned address map entries (pairs of vAddr, pAddr)
+	//    used bitmap words
+	//    dirty bitmap words (only when the ftl does garbage collection)
+	struct CheckpointHeader{
+		char magic[8];
+		uint32_t version;
+		uint32_t flags;
+		uint64_t byte_order;
+
+		uint64_t total_size;
+		uint64_t virtual_total_size;
+		uint64_t page_size;
+		uint64_t blocks;
+		uint64_t pages_per_block;
+
+		uint64_t map_entry_bytes;
+		uint64_t map_pages;
+		uint64_t unaligned_entries;
+		uint64_t bitmap_words;
+
+		uint64_t map_offset;
+		uint64_t unaligned_offset;
+		uint64_t used_offset;
+		uint64_t dirty_offset;
+		uint64_t file_size;
+	};
+
+	class Checkpoint{
+		public:
+			Checkpoint(void);
+			~Checkpoint(void);
+
+			// true if the file starts with the checkpoint magic, anything else is treated as the old text format
+			static bool isCheckpoint(std::string filename);
+			static void save(std::string filename, MappingTable &map, PageBitmap &used, PageBitmap *dirty);
+
+			// maps the file and checks it against the current geometry and the tables it will be loaded into,
+			// aborts if they don't match
+			void open(std::string filename, const MappingTable &map, const PageBitmap &used);
+
+			bool hasDirty(void) const { return (header->flags & CHECKPOINT_HAS_DIRTY) != 0; }
+			const void *mapEntries(void) const { return base + header->map_offset; }
+			const uint64_t *unalignedEntries(void) const { return (const uint64_t *) (base + header->unaligned_offset); }
+			uint64_t unalignedCount(void) const { return header->unaligned_entries; }
+			const uint64_t *usedWords(void) const { return (const uint64_t *) (base + header->used_offset); }
+			const uint64_t *dirtyWords(void) const { return (const uint64_t *) (base + header->dirty_offset); }
+
+		private:
+			Checkpoint(const Checkpoint &);
+			Checkpoint &operator=(const Checkpoint &);
+
+			static uint64_t align(uint64_t offset) { return (offset + 7) & ~(uint64_t) 7; }
+			// fills in where each section goes from the sizes in the header
+			static void layout(CheckpointHeader *h);
+
+			const char *base;
+			uint64_t length;
+			const CheckpointHeader *header;
+	};
+}
+#endif
@@ -0,0 +1,84 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//CompletionRing.cpp
+//class file for the ring that completions are queued on for the host
+
+#include "CompletionRing.h"
+
+using namespace NVDSim;
+
+CompletionRing::CompletionRing(uint64_t capacity)
+{
+	this->capacity = capacity;
+	entries = new Completion[capacity];
+	head = 0;
+	tail = 0;
+	num_dropped = 0;
+}
+
+CompletionRing::~CompletionRing(void)
+{
+	delete [] entries;
+}
+
+bool CompletionRing::push(uint64_t id, uint64_t address, CompletionType type, uint64_t cycle, bool mapped)
+{
+	if (full())
+	{
+		num_dropped++;
+		return false;
+	}
+
+	Completion &c = entries[tail % capacity];
+	c.id = id;
+	c.address = address;
+	c.type = type;
+	c.cycle = cycle;
+	c.mapped = mapped;
+	tail++;
+	return true;
+}
+
+// copies out up to max of the oldest completions and returns how many there were
+uint64_t CompletionRing::drain(Completion *out, uint64_t max)
+{
+	uint64_t n = 0;
+	while (n < max && head != tail)
+	{
+		out[n] = entries[head % capacity];
+		head++;
+		n++;
+	}
+	return n;
+}
@@ -0,0 +1,69 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVCOMPLETIONRING_H
+#define NVCOMPLETIONRING_H
+//CompletionRing.h
+//header file for the ring that completions are queued on for the host
+
+#include "HostInterface.h"
+
+namespace NVDSim
+{
+	// A fixed size ring of completions, everything is allocated up front so queueing a completion is
+	// just a copy into the next slot. The host drains it whenever it likes, if it lets the ring fill up
+	// the newest completions are dropped and counted.
+	// It isn't thread safe, the NVDIMM only queues completions from the thread that calls update so the
+	// host should drain from that thread too.
+	class CompletionRing
+	{
+	public:
+		CompletionRing(uint64_t capacity);
+		~CompletionRing(void);
+
+		bool push(uint64_t id, uint64_t address, CompletionType type, uint64_t cycle, bool mapped);
+		uint64_t drain(Completion *out, uint64_t max);
+
+		uint64_t size(void) { return tail - head; }
+		bool full(void) { return tail - head == capacity; }
+		uint64_t dropped(void) { return num_dropped; }
+
+	private:
+		Completion *entries;
+		uint64_t capacity;
+		uint64_t head, tail; // only ever go up, the slot is taken mod capacity
+		uint64_t num_dropped;
+	};
+}
+
+#endif
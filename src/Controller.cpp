@@ -57,7 +57,34 @@ Controller::Controller(NVDIMM* parent, Logger* l){
 	    paused[i] = false;
 	}
 
+	queue_access_counter = 0;
+
+	readBypassed = vector<uint>(NUM_PACKAGES, 0);
+	writeBypassed = vector<uint>(NUM_PACKAGES, 0);
+
 	currentClockCycle = 0;
+
+	// Note: NV_PAGE_SIZE is multiplied by 8192 since the parameter is given in KB and this is how many bits
+	// are in 1 KB (1024 * 8).
+	data_beats = divide_params((NV_PAGE_SIZE*8192),CHANNEL_WIDTH);
+	command_beats = divide_params(COMMAND_LENGTH,CHANNEL_WIDTH);
+	write_queue_trigger = CTRL_WRITE_ON_QUEUE_SIZE ? CTRL_WRITE_QUEUE_LIMIT : CTRL_WRITE_QUEUE_LENGTH-1;
+	schedule_window = CTRL_SCHEDULE_WINDOW > 1 ? CTRL_SCHEDULE_WINDOW : 1;
+
+	// indexed by ctrl schedule, buffered and logging
+	static void (Controller::*const kernels[8])(void) = {
+		&Controller::updateKernel<0,0,0>, &Controller::updateKernel<0,0,1>, &Controller::updateKernel<0,1,0>, &Controller::updateKernel<0,1,1>,
+		&Controller::updateKernel<1,0,0>, &Controller::updateKernel<1,0,1>, &Controller::updateKernel<1,1,0>, &Controller::updateKernel<1,1,1>
+	};
+#ifdef GENERIC_KERNELS
+	update_kernel = &Controller::updateKernel<RUNTIME_FLAG, RUNTIME_FLAG, RUNTIME_FLAG>;
+#else
+	update_kernel = kernels[(CTRL_SCHEDULE ? 4 : 0) + (BUFFERED ? 2 : 0) + (LOGGING ? 1 : 0)];
+#endif
+}
+
+Controller::~Controller(void){
+	delete [] paused;
 }
 
 void Controller::attachPackages(vector<Package> *packages){
@@ -65,23 +92,21 @@ void Controller::attachPackages(vector<Package> *packages){
 }
 
 void Controller::returnReadData(const FlashTransaction  &trans){
-	if(parentNVDIMM->ReturnReadData!=NULL){
-	    (*parentNVDIMM->ReturnReadData)(parentNVDIMM->systemID, trans.address, currentClockCycle, true);
-	}
+	parentNVDIMM->readDone(trans.id, trans.address, currentClockCycle, true);
 	parentNVDIMM->numReads++;
 }
 
 void Controller::returnUnmappedData(const FlashTransaction  &trans){
-	if(parentNVDIMM->ReturnReadData!=NULL){
-	    (*parentNVDIMM->ReturnReadData)(parentNVDIMM->systemID, trans.address, currentClockCycle, false);
-	}
+	parentNVDIMM->readDone(trans.id, trans.address, currentClockCycle, false);
 	parentNVDIMM->numReads++;
 }
 
 void Controller::returnCritLine(ChannelPacket *busPacket){
-	if(parentNVDIMM->CriticalLineDone!=NULL){
-	    (*parentNVDIMM->CriticalLineDone)(parentNVDIMM->systemID, busPacket->virtualAddress, currentClockCycle, true);
-	}
+	uint64_t id = busPacket->id, vAddr = busPacket->virtualAddress;
+	// this comes from the dies so it has to wait if the packages are being updated in parallel
+	parentNVDIMM->packageEvent(busPacket->package, [=] {
+		parentNVDIMM->critLineDone(id, vAddr, currentClockCycle);
+	});
 }
 
 void Controller::returnPowerData(vector<double> idle_energy, vector<double> access_energy, vector<double> erase_energy,
@@ -142,28 +167,31 @@ void Controller::returnPowerData(vector<double> idle_energy, vector<double> acce
 }
 
 void Controller::receiveFromChannel(ChannelPacket *busPacket){
-	// READ is now done. Log it and call delete
-	if(LOGGING == true)
-	{
-		log->access_stop(busPacket->virtualAddress, busPacket->physicalAddress);
-	}
+	// this comes from the packages so it has to wait if they are being updated in parallel
+	parentNVDIMM->packageEvent(busPacket->package, [=] {
+		// READ is now done. Log it and release the packet
+		if(LOGGING == true)
+		{
+			log->access_stop(busPacket->id);
+		}
 
-	// Put in the returnTransaction queue 
-	switch (busPacket->busPacketType)
-	{
-		case READ:
-			returnTransaction.push_back(FlashTransaction(RETURN_DATA, busPacket->virtualAddress, busPacket->data));
-			break;
-		case GC_READ:
-			// Nothing to do.
-			break;
-		default:
-			ERROR("Illegal busPacketType " << busPacket->busPacketType << " in Controller::receiveFromChannel\n");
-			break;
-	}
+		// Put in the returnTransaction queue 
+		switch (busPacket->busPacketType)
+		{
+			case READ:
+				returnTransaction.push_back(FlashTransaction(RETURN_DATA, busPacket->id, busPacket->virtualAddress, busPacket->data));
+				break;
+			case GC_READ:
+				// Nothing to do.
+				break;
+			default:
+				ERROR("Illegal busPacketType " << busPacket->busPacketType << " in Controller::receiveFromChannel\n");
+				break;
+		}
 
-	// Delete the ChannelPacket since READ is done. This must be done to prevent memory leaks.
-	delete(busPacket);
+		// Give the ChannelPacket back since READ is done.
+		parentNVDIMM->releasePacket(busPacket);
+	});
 }
 
 // this is only called on a write as the name suggests
@@ -212,24 +240,28 @@ bool Controller::addPacket(ChannelPacket *p){
 		     {
 			 if((*it)->virtualAddress == p->virtualAddress && (*it)->busPacketType == p->busPacketType)
 			 {
-			     if(LOGGING)
-			     {		
-				 // access_process for that write is called here since its over now.
-				 log->access_process((*it)->virtualAddress, (*it)->physicalAddress, (*it)->package, WRITE);
+			     // the write and its data are both replaced, only finish the request once
+			     if((*it)->busPacketType == WRITE)
+			     {
+				 if(LOGGING)
+				 {		
+				     // access_process for that write is called here since its over now.
+				     log->access_process((*it)->id, (*it)->physicalAddress, (*it)->package, WRITE);
 				 
-				 // stop_process for that write is called here since its over now.
-				 log->access_stop((*it)->virtualAddress, (*it)->physicalAddress);
-			     }
-			     //call write callback
-			     if (parentNVDIMM->WriteDataDone != NULL){
-				 (*parentNVDIMM->WriteDataDone)(parentNVDIMM->systemID, (*it)->virtualAddress, currentClockCycle,true);
+				     // stop_process for that write is called here since its over now.
+				     log->access_stop((*it)->id);
+				 }
+				 //call write callback
+				 parentNVDIMM->writeDone((*it)->id, (*it)->virtualAddress, currentClockCycle);
 			     }
-			     writeQueues[(*it)->package].erase(it, it++);
+			     parentNVDIMM->releasePacket(*it);
+			     writeQueues[p->package].erase(it);
 			     break;
 			 }
 		     }   
 		 }
 		 writeQueues[p->package].push_back(p);
+		 sendQueueLength(p->package);
 		 break;
 	     }
 	     else
@@ -249,6 +281,10 @@ bool Controller::addPacket(ChannelPacket *p){
 	    break;
 	}
     
+	if(LOGGING)
+	{
+	    log->access_stage(p->id, CTRL_QUEUE_STAGE);
+	}
 	if(LOGGING && QUEUE_EVENT_LOG)
 	{
 	    switch (p->busPacketType)
@@ -277,6 +313,10 @@ bool Controller::addPacket(ChannelPacket *p){
 	{
 	    readQueues[p->package].push_back(p);
     
+	    if(LOGGING)
+	    {
+		log->access_stage(p->id, CTRL_QUEUE_STAGE);
+	    }
 	    if(LOGGING && QUEUE_EVENT_LOG)
 	    {
 		log->log_ctrl_queue_event(false, p->package, &readQueues[p->package]);
@@ -291,36 +331,40 @@ bool Controller::addPacket(ChannelPacket *p){
 }
 
 void Controller::update(void){
+    (this->*update_kernel)();
+}
+
+template <int ctrl_schedule, int buffered, int logging>
+void Controller::updateKernel(void){
     // schedule the next operation for each die
-    if(CTRL_SCHEDULE)
+    if(KERNEL_FLAG(ctrl_schedule, CTRL_SCHEDULE))
     {
 	bool write_queue_handled = false;
 	uint64_t i;	
+	list<ChannelPacket *>::iterator it;
 	//loop through the channels to find a packet for each
-	for (i = 0; i < NUM_PACKAGES; i++){
+	for (i = 0; i < outgoingPackets.size(); i++){
 	    // do we need to issue a write
-	    if((CTRL_WRITE_ON_QUEUE_SIZE == true && writeQueues[i].size() >= CTRL_WRITE_QUEUE_LIMIT) ||
-	       (CTRL_WRITE_ON_QUEUE_SIZE == false && writeQueues[i].size() >= CTRL_WRITE_QUEUE_LENGTH-1))
+	    if(writeQueues[i].size() >= write_queue_trigger)
 	    {
 		if (!writeQueues[i].empty() && outgoingPackets[i]==NULL){
+		    it = pickPacket(writeQueues[i], writeBypassed[i]);
 		    //if we can get the channel
-		    if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, writeQueues[i].front())){
-			outgoingPackets[i] = writeQueues[i].front();
-			if(LOGGING && QUEUE_EVENT_LOG)
+		    if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, *it)){
+			outgoingPackets[i] = *it;
+			if(KERNEL_FLAG(logging, LOGGING) && QUEUE_EVENT_LOG)
 			{
-			    log->log_ctrl_queue_event(true, writeQueues[i].front()->package, &writeQueues[i]);
+			    log->log_ctrl_queue_event(true, (*it)->package, &writeQueues[i]);
 			}
-			writeQueues[i].pop_front();
+			takePacket(writeQueues[i], it, writeBypassed[i]);
 			parentNVDIMM->queuesNotFull();
 			
 			switch (outgoingPackets[i]->busPacketType){
 			case DATA:
-			    // Note: NV_PAGE_SIZE is multiplied by 8192 since the parameter is given in KB and this is how many bits
-			    // are in 1 KB (1024 * 8).
-			    channelBeatsLeft[i] = divide_params((NV_PAGE_SIZE*8192),CHANNEL_WIDTH); 
+			    channelBeatsLeft[i] = data_beats;
 			    break;
 			default:
-			    channelBeatsLeft[i] = divide_params(COMMAND_LENGTH,CHANNEL_WIDTH);
+			    channelBeatsLeft[i] = command_beats;
 			    break;
 			}
 		    }
@@ -332,15 +376,14 @@ void Controller::update(void){
 		   readQueues[i].front()->busPacketType != GC_WRITE && !writeQueues[i].empty())
 		{
 		    //see if this read can be satisfied by something in the write queue
-		    list<ChannelPacket *>::iterator it;
 		    for (it = writeQueues[i].begin(); it != writeQueues[i].end(); it++)
 		    {
 			if((*it)->virtualAddress == readQueues[i].front()->virtualAddress)
 			{
-			    if(LOGGING)
+			    if(KERNEL_FLAG(logging, LOGGING))
 			    {		
 				// access_process for the read we're satisfying  is called here since we're doing it here.
-				log->access_process(readQueues[i].front()->virtualAddress, readQueues[i].front()->physicalAddress, 
+				log->access_process(readQueues[i].front()->id, readQueues[i].front()->physicalAddress, 
 						    readQueues[i].front()->package, READ);
 			    }
 			    queue_access_counter = QUEUE_ACCESS_TIME;
@@ -355,52 +398,53 @@ void Controller::update(void){
 		    write_queue_handled = true;
 		    if(queue_access_counter == 0)
 		    {
-			if(LOGGING)
+			if(KERNEL_FLAG(logging, LOGGING))
 			{
 			    // stop_process for this read is called here since this ends now.
-			    log->access_stop(readQueues[i].front()->virtualAddress, readQueues[i].front()->virtualAddress);
+			    log->access_stop(readQueues[i].front()->id);
 			}
 
-			returnReadData(FlashTransaction(RETURN_DATA, readQueues[i].front()->virtualAddress, readQueues[i].front()->data));
+			returnReadData(FlashTransaction(RETURN_DATA, readQueues[i].front()->id, readQueues[i].front()->virtualAddress, readQueues[i].front()->data));
+			parentNVDIMM->releasePacket(readQueues[i].front());
 			readQueues[i].pop_front();
 		    }
 		}
 		else if(!write_queue_handled)
 		{
+		    it = pickPacket(readQueues[i], readBypassed[i]);
 		    //if we can get the channel
-		    if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, readQueues[i].front())){
-			outgoingPackets[i] = readQueues[i].front();
-			if(LOGGING && QUEUE_EVENT_LOG)
+		    if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, *it)){
+			outgoingPackets[i] = *it;
+			if(KERNEL_FLAG(logging, LOGGING) && QUEUE_EVENT_LOG)
 			{
-			    log->log_ctrl_queue_event(false, readQueues[i].front()->package, &readQueues[i]);
+			    log->log_ctrl_queue_event(false, (*it)->package, &readQueues[i]);
 			}
-			readQueues[i].pop_front();
+			takePacket(readQueues[i], it, readBypassed[i]);
 			parentNVDIMM->queuesNotFull();
 			
-			channelBeatsLeft[i] = divide_params(COMMAND_LENGTH,CHANNEL_WIDTH);
+			channelBeatsLeft[i] = command_beats;
 		    }
 		}
 	    }
 	    // if there are no reads to send see if we're allowed to send a write instead
 	    else if (CTRL_IDLE_WRITE == true && !writeQueues[i].empty() && outgoingPackets[i]==NULL){
+		it = pickPacket(writeQueues[i], writeBypassed[i]);
 		//if we can get the channel
-		if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, writeQueues[i].front())){
-		    outgoingPackets[i] = writeQueues[i].front();
-		    if(LOGGING && QUEUE_EVENT_LOG)
+		if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, *it)){
+		    outgoingPackets[i] = *it;
+		    if(KERNEL_FLAG(logging, LOGGING) && QUEUE_EVENT_LOG)
 		    {
-			log->log_ctrl_queue_event(true, writeQueues[i].front()->package, &writeQueues[i]);
+			log->log_ctrl_queue_event(true, (*it)->package, &writeQueues[i]);
 		    }
-		    writeQueues[i].pop_front();
+		    takePacket(writeQueues[i], it, writeBypassed[i]);
 		    parentNVDIMM->queuesNotFull();
 		    
 		    switch (outgoingPackets[i]->busPacketType){
 		    case DATA:
-			// Note: NV_PAGE_SIZE is multiplied by 8192 since the parameter is given in KB and this is how many bits
-			// are in 1 KB (1024 * 8).
-			channelBeatsLeft[i] = divide_params((NV_PAGE_SIZE*8192),CHANNEL_WIDTH); 
+			channelBeatsLeft[i] = data_beats;
 			break;
 		    default:
-			channelBeatsLeft[i] = divide_params(COMMAND_LENGTH,CHANNEL_WIDTH);
+			channelBeatsLeft[i] = command_beats;
 			break;
 		    }
 		}
@@ -411,38 +455,38 @@ void Controller::update(void){
     else
     {
 	uint64_t i;	
+	list<ChannelPacket *>::iterator it;
 	//Look through queues and send oldest packets to the appropriate channel
-	for (i = 0; i < NUM_PACKAGES; i++){
+	for (i = 0; i < outgoingPackets.size(); i++){
 	    if (!readQueues[i].empty() && outgoingPackets[i]==NULL){
+		it = pickPacket(readQueues[i], readBypassed[i]);
 		//if we can get the channel
-		if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, readQueues[i].front())){
-		    outgoingPackets[i] = readQueues[i].front();
-		    if(LOGGING && QUEUE_EVENT_LOG)
+		if ((*packages)[i].channel->obtainChannel(0, CONTROLLER, *it)){
+		    outgoingPackets[i] = *it;
+		    if(KERNEL_FLAG(logging, LOGGING) && QUEUE_EVENT_LOG)
 		    {
-			switch (readQueues[i].front()->busPacketType)
+			switch ((*it)->busPacketType)
 			{
 			case READ:
 			case GC_READ:
 			case ERASE:
-			    log->log_ctrl_queue_event(false, readQueues[i].front()->package, &readQueues[i]);
+			    log->log_ctrl_queue_event(false, (*it)->package, &readQueues[i]);
 			    break;
 			case WRITE:
 			case GC_WRITE:
 			case DATA:
-			    log->log_ctrl_queue_event(true, readQueues[i].front()->package, &readQueues[i]);
+			    log->log_ctrl_queue_event(true, (*it)->package, &readQueues[i]);
 			    break;
 			}
 		    }
-		    readQueues[i].pop_front();
+		    takePacket(readQueues[i], it, readBypassed[i]);
 		    parentNVDIMM->queuesNotFull();
 		    switch (outgoingPackets[i]->busPacketType){
 		    case DATA:
-			// Note: NV_PAGE_SIZE is multiplied by 8192 since the parameter is given in KB and this is how many bits
-			// are in 1 KB (1024 * 8).
-			channelBeatsLeft[i] = divide_params((NV_PAGE_SIZE*8192),CHANNEL_WIDTH); 
+			channelBeatsLeft[i] = data_beats;
 			break;
 		    default:
-			channelBeatsLeft[i] = divide_params(COMMAND_LENGTH,CHANNEL_WIDTH);
+			channelBeatsLeft[i] = command_beats;
 			break;
 		    }
 		}
@@ -451,7 +495,7 @@ void Controller::update(void){
     }
 	
     //Use the buffer code for the NVDIMMS to calculate the actual transfer time
-    if(BUFFERED)
+    if(KERNEL_FLAG(buffered, BUFFERED))
     {	
 	uint64_t i;
 	//Check for commands/data on a channel. If there is, see if it is done on channel
@@ -512,16 +556,92 @@ void Controller::update(void){
     }
 }
 
-void Controller::sendQueueLength(void)
+// Choose the packet to send next out of the first schedule_window packets in a queue. This is the oldest
+// one whose die can take it right now, so a busy die doesn't hold up the packets behind it for idle dies.
+// A packet never passes an older one for the same die and plane, and once the head of the queue has been
+// passed over CTRL_SCHEDULE_AGE times it has to go next. If nothing is ready the head is tried as usual.
+list<ChannelPacket *>::iterator Controller::pickPacket(list<ChannelPacket *> &queue, uint &bypassed)
 {
-	vector<uint64_t> temp = vector<uint64_t>(writeQueues.size(),0);
-	for(uint i = 0; i < writeQueues.size(); i++)
+    list<ChannelPacket *>::iterator it, older;
+    uint64_t n;
+
+    if (schedule_window == 1 || (CTRL_SCHEDULE_AGE != 0 && bypassed >= CTRL_SCHEDULE_AGE))
+    {
+	return queue.begin();
+    }
+
+    for (it = queue.begin(), n = 0; it != queue.end() && n < schedule_window; it++, n++)
+    {
+	for (older = queue.begin(); older != it; older++)
 	{
-		temp[i] = writeQueues[i].size();
+	    if ((*older)->die == (*it)->die && (*older)->plane == (*it)->plane)
+	    {
+		break;
+	    }
 	}
+	if (older == it && packetReady(*it))
+	{
+	    return it;
+	}
+    }
+    return queue.begin();
+}
+
+// take a packet that is being sent out of its queue, the channel has just been obtained for it
+void Controller::takePacket(list<ChannelPacket *> &queue, list<ChannelPacket *>::iterator it, uint &bypassed)
+{
+    uint64_t package = (*it)->package;
+    if (LOGGING)
+    {
+	log->access_stage((*it)->id, CHANNEL_STAGE);
+    }
+    if (it == queue.begin())
+    {
+	bypassed = 0;
+    }
+    else
+    {
+	bypassed++;
+    }
+    queue.erase(it);
+    sendQueueLength(package);
+}
+
+// can the die the packet is going to take it now
+bool Controller::packetReady(ChannelPacket *p)
+{
+    if (BUFFERED)
+    {
+	return !(*packages)[p->package].channel->isBufferFull(CONTROLLER, p->die);
+    }
+    return !(*packages)[p->package].dies[p->die]->isDieBusy(p->plane);
+}
+
+// the controller is idle once all of its queues have drained and nothing is on the channels
+// packets waiting on the buffers are finished by Buffer::update so they don't count here
+uint64_t Controller::nextEvent(void)
+{
+	if (!returnTransaction.empty())
+	{
+		return 0;
+	}
+
+	for (uint64_t i = 0; i < NUM_PACKAGES; i++)
+	{
+		if (!readQueues[i].empty() || !writeQueues[i].empty() || outgoingPackets[i] != NULL)
+		{
+			return 0;
+		}
+	}
+
+	return NO_EVENT;
+}
+
+void Controller::sendQueueLength(uint64_t package)
+{
 	if(LOGGING == true)
 	{
-		log->ctrlQueueLength(temp);
+		log->ctrlQueueLength(package, writeQueues[package].size());
 	}
 }
 
@@ -530,16 +650,26 @@ void Controller::writeToPackage(ChannelPacket *packet)
 	(*packages)[packet->package].dies[packet->die]->writeToPlane(packet);
 }
 
+void Controller::eraseInPackage(ChannelPacket *packet)
+{
+	(*packages)[packet->package].dies[packet->die]->eraseInPlane(packet);
+}
+
+void Controller::populatePackage(uint package, uint die, uint plane, uint block, const uint64_t *pages, uint64_t words)
+{
+	(*packages)[package].dies[die]->populatePlane(plane, block, pages, words);
+}
+
 void Controller::bufferDone(uint64_t package, uint64_t die, uint64_t plane)
 {
-	for (uint i = 0; i < pendingPackets.size(); i++){
-		std::list<ChannelPacket *>::iterator it;
-		for(it = pendingPackets[i].begin(); it != pendingPackets[i].end(); it++){
-		    if ((*it) != NULL && (*it)->package == package && (*it)->die == die && (*it)->plane == plane){
-				(*packages)[(*it)->package].channel->sendToBuffer((*it));
-				pendingPackets[i].erase(it);
-				break;
-		    }
-		}
+	// pending packets are kept per package so only look at this package's list
+	// the other lists may be in use by other threads if the packages are updated in parallel
+	std::list<ChannelPacket *>::iterator it;
+	for(it = pendingPackets[package].begin(); it != pendingPackets[package].end(); it++){
+	    if ((*it) != NULL && (*it)->die == die && (*it)->plane == plane){
+			(*packages)[package].channel->sendToBuffer((*it));
+			pendingPackets[package].erase(it);
+			break;
+	    }
 	}
 }
@@ -57,6 +57,7 @@ namespace NVDSim{
 	class Controller : public SimObj{
 		public:
 	                Controller(NVDIMM* parent, Logger* l);
+			~Controller(void);
 
 			void attachPackages(vector<Package> *packages);
 			void returnReadData(const FlashTransaction &trans);
@@ -82,13 +83,26 @@ namespace NVDSim{
 			bool checkQueueWrite(ChannelPacket *p);
 			bool addPacket(ChannelPacket *p);
 			void update(void);
+			uint64_t nextEvent(void);
 
-			void sendQueueLength(void);
+			// the update for this controller's flags, see FlashConfiguration.h
+			template <int ctrl_schedule, int buffered, int logging> void updateKernel(void);
+
+			// tells the logger how long a package's write queue is, this is called whenever it changes
+			void sendQueueLength(uint64_t package);
 
 			void bufferDone(uint64_t package, uint64_t die, uint64_t plane);
 
+			// out of order dispatch
+			std::list<ChannelPacket *>::iterator pickPacket(std::list<ChannelPacket *> &queue, uint &bypassed);
+			void takePacket(std::list<ChannelPacket *> &queue, std::list<ChannelPacket *>::iterator it, uint &bypassed);
+			bool packetReady(ChannelPacket *p);
+
 			// for fast forwarding
 			void writeToPackage(ChannelPacket *packet);
+			void eraseInPackage(ChannelPacket *packet);
+			// for restoring a checkpoint, writes all of the pages set in one block's bitmap words
+			void populatePackage(uint package, uint die, uint plane, uint block, const uint64_t *pages, uint64_t words);
 
 			NVDIMM *parentNVDIMM;
 			Logger *log;
@@ -106,7 +120,16 @@ namespace NVDSim{
 			std::vector<std::list <ChannelPacket *> > pendingPackets; //there can be a pending package for each plane of each die of each package
 			std::vector<uint> channelXferCyclesLeft; //cycles per channel beat
 			std::vector<uint> channelBeatsLeft; //channel beats per page
+			std::vector<uint> readBypassed; //times the head of each read queue has been passed over
+			std::vector<uint> writeBypassed;
+
+			void (Controller::*update_kernel)(void);
 
+			// timing that only depends on the config, worked out once when the controller is built
+			uint data_beats; //channel beats per page
+			uint command_beats; //channel beats per command
+			uint64_t write_queue_trigger; //a write queue this long has to issue a write
+			uint64_t schedule_window; //packets at the front of a queue that can be sent out of order
 	};
 }
 #endif
@@ -60,6 +60,36 @@ Die::Die(NVDIMM *parent, Logger *l, uint64_t idNum){
 	currentClockCycle= 0;
 
 	critBeat = ((divide_params((NV_PAGE_SIZE*8192),DEVICE_WIDTH)-divide_params((uint)512,DEVICE_WIDTH)) * DEVICE_CYCLE) / CYCLE_TIME; // cache line is 64 bytes
+
+	read_cycles = READ_TIME;
+	// without gc PCM writes in place which takes as long as an erase
+	if((DEVICE_TYPE.compare("PCM") == 0 || DEVICE_TYPE.compare("P8P") == 0) && GARBAGE_COLLECT == 0)
+	{
+		write_cycles = ERASE_TIME;
+	}
+	else
+	{
+		write_cycles = WRITE_TIME;
+	}
+	erase_cycles = ERASE_TIME;
+	device_cycles = divide_params(DEVICE_CYCLE,CYCLE_TIME);
+	page_beats = divide_params((NV_PAGE_SIZE*8192),DEVICE_WIDTH);
+	page_cycles = (page_beats * DEVICE_CYCLE) / CYCLE_TIME;
+
+	// indexed by buffered, logging and crit line first
+	static void (Die::*const kernels[8])(void) = {
+		&Die::updateKernel<0,0,0>, &Die::updateKernel<0,0,1>, &Die::updateKernel<0,1,0>, &Die::updateKernel<0,1,1>,
+		&Die::updateKernel<1,0,0>, &Die::updateKernel<1,0,1>, &Die::updateKernel<1,1,0>, &Die::updateKernel<1,1,1>
+	};
+#ifdef GENERIC_KERNELS
+	update_kernel = &Die::updateKernel<RUNTIME_FLAG, RUNTIME_FLAG, RUNTIME_FLAG>;
+#else
+	update_kernel = kernels[(BUFFERED ? 4 : 0) + (LOGGING ? 2 : 0) + (CRIT_LINE_FIRST ? 1 : 0)];
+#endif
+}
+
+Die::~Die(void){
+	delete [] controlCyclesLeft;
 }
 
 void Die::attachToBuffer(Buffer *buff){
@@ -71,63 +101,49 @@ void Die::receiveFromBuffer(ChannelPacket *busPacket){
 		planes[busPacket->plane].storeInData(busPacket);
 	} else if (currentCommands[busPacket->plane] == NULL) {
 		currentCommands[busPacket->plane] = busPacket;
-		if (LOGGING)
-		{
-			// Tell the logger the access has now been processed.		        
-			log->access_process(busPacket->virtualAddress, busPacket->physicalAddress, busPacket->package, busPacket->busPacketType);		
-		}
+
+		uint64_t id = busPacket->id, pAddr = busPacket->physicalAddress;
+		uint64_t package = busPacket->package, die = busPacket->die, plane = busPacket->plane;
+		ChannelPacketType type = busPacket->busPacketType;
+		PlaneStateType state = IDLE;
+
 		switch (busPacket->busPacketType){
 			case READ:
 			case GC_READ:
-				controlCyclesLeft[busPacket->plane]= READ_TIME;
-				// log the new state of this plane
-				if(LOGGING && PLANE_STATE_LOG)
-				{
-				    if(busPacket->busPacketType == READ)
-				    {
-					log->log_plane_state(busPacket->package, busPacket->die, busPacket->plane, READING);
-				    }
-				    else if(busPacket->busPacketType == GC_READ)
-				    {
-					log->log_plane_state(busPacket->package, busPacket->die, busPacket->plane, GC_READING);
-				    }
-				}
+				controlCyclesLeft[busPacket->plane]= read_cycles;
+				// the new state of this plane
+				state = (busPacket->busPacketType == READ) ? READING : GC_READING;
 				break;
 			case WRITE:
 			case GC_WRITE:
-			        if((DEVICE_TYPE.compare("PCM") == 0 || DEVICE_TYPE.compare("P8P") == 0) && GARBAGE_COLLECT == 0)
-				{
-					controlCyclesLeft[busPacket->plane]= ERASE_TIME;
-				}
-				else
-				{
-					controlCyclesLeft[busPacket->plane]= WRITE_TIME;
-				}
-				// log the new state of this plane
-				if(LOGGING && PLANE_STATE_LOG)
-				{
-				    if(busPacket->busPacketType == WRITE)
-				    {
-					log->log_plane_state(busPacket->package, busPacket->die, busPacket->plane, WRITING);
-				    }
-				    else if(busPacket->busPacketType == GC_WRITE)
-				    {
-					log->log_plane_state(busPacket->package, busPacket->die, busPacket->plane, GC_WRITING);
-				    }
-				}
+				controlCyclesLeft[busPacket->plane]= write_cycles;
+				// the new state of this plane
+				state = (busPacket->busPacketType == WRITE) ? WRITING : GC_WRITING;
 				break;
 			case ERASE:
-			        controlCyclesLeft[busPacket->plane]= ERASE_TIME;
+			        controlCyclesLeft[busPacket->plane]= erase_cycles;
 
-				// log the new state of this plane
-				if(LOGGING && PLANE_STATE_LOG)
-				{
-				    log->log_plane_state(busPacket->package, busPacket->die, busPacket->plane, ERASING);
-				}
+				// the new state of this plane
+				state = ERASING;
 				break;
 			default:
 				break;			
 		}
+
+		if (LOGGING)
+		{
+			// the logger is shared by all of the packages
+			parentNVDIMM->packageEvent(package, [=] {
+				// Tell the logger the access has now been processed.
+				log->access_process(id, pAddr, package, type);
+				log->access_stage(id, DIE_STAGE);
+				// log the new state of this plane
+				if (PLANE_STATE_LOG && state != IDLE)
+				{
+					log->log_plane_state(package, die, plane, state);
+				}
+			});
+		}
 	} else{
 		ERROR("Die is busy");
 		exit(1);
@@ -142,15 +158,25 @@ int Die::isDieBusy(uint64_t plane){
 }
 
 void Die::update(void){
+	(this->*update_kernel)();
+}
+
+template <int buffered, int logging, int crit_line_first>
+void Die::updateKernel(void){
 	uint64_t i;
 	ChannelPacket *currentCommand;
 
-	for (i = 0 ; i < PLANES_PER_DIE ; i++){
+	for (i = 0 ; i < planes.size() ; i++){
 		currentCommand = currentCommands[i];
 		if (currentCommand != NULL){
 			if (controlCyclesLeft[i] == 0){
 
+				uint64_t id = currentCommand->id, vAddr = currentCommand->virtualAddress;
+				uint64_t package = currentCommand->package, die = currentCommand->die, plane = currentCommand->plane;
+				uint64_t cycle = currentClockCycle;
+
 				// Process each command based on the packet type.
+				// Anything that leaves the package goes through packageEvent.
 				switch (currentCommand->busPacketType){
 					case READ:	
 						planes[currentCommand->plane].read(currentCommand);
@@ -159,23 +185,31 @@ void Die::update(void){
 					case GC_READ:
 					        planes[currentCommand->plane].read(currentCommand);
 						returnDataPackets.push(planes[currentCommand->plane].readFromData());
-						parentNVDIMM->GCReadDone(currentCommand->virtualAddress);
+						parentNVDIMM->packageEvent(package, [=] {
+							parentNVDIMM->GCReadDone(vAddr);
+						});
 						break;
 					case WRITE:				     
 						planes[currentCommand->plane].write(currentCommand);
-						parentNVDIMM->numWrites++;					
-						//call write callback
-						if (parentNVDIMM->WriteDataDone != NULL){
-						    (*parentNVDIMM->WriteDataDone)(parentNVDIMM->systemID, currentCommand->virtualAddress, currentClockCycle,true);
-						}
+						parentNVDIMM->releasePacket(planes[currentCommand->plane].readFromData());
+						parentNVDIMM->packageEvent(package, [=] {
+							parentNVDIMM->numWrites++;
+							//call write callback
+							parentNVDIMM->writeDone(id, vAddr, cycle);
+						});
 						break;
 					case GC_WRITE:
 						planes[currentCommand->plane].write(currentCommand);
-						parentNVDIMM->numWrites++;
+						parentNVDIMM->releasePacket(planes[currentCommand->plane].readFromData());
+						parentNVDIMM->packageEvent(package, [=] {
+							parentNVDIMM->numWrites++;
+						});
 						break;
 					case ERASE:
 						planes[currentCommand->plane].erase(currentCommand);
-						parentNVDIMM->numErases++;
+						parentNVDIMM->packageEvent(package, [=] {
+							parentNVDIMM->numErases++;
+						});
 						break;
 					case DATA:
 						// Nothing to do.
@@ -191,17 +225,26 @@ void Die::update(void){
 					// For DATA, this is handled as part of the WRITE in Plane.
 
 					// Tell the logger the access is done.
-					if (LOGGING)
+					if (KERNEL_FLAG(logging, LOGGING))
 					{
-					    log->access_stop(currentCommand->virtualAddress, currentCommand->physicalAddress);
-					    if(PLANE_STATE_LOG)
-					    {
-						log->log_plane_state(currentCommand->package, currentCommand->die, currentCommand->plane, IDLE);
-					    }
+					    parentNVDIMM->packageEvent(package, [=] {
+						log->access_stop(id);
+						if(PLANE_STATE_LOG)
+						{
+						    log->log_plane_state(package, die, plane, IDLE);
+						}
+					    });
 					}
 
-					// Delete the memory allocated for the current command to prevent memory leaks.
-					delete currentCommand;
+					// Give the current command back to the pool.
+					parentNVDIMM->releasePacket(currentCommand);
+				}
+				else if (((bpt == READ) || (bpt == GC_READ)) && KERNEL_FLAG(logging, LOGGING))
+				{
+					// the data is on its way back to the controller now
+					parentNVDIMM->packageEvent(package, [=] {
+						log->access_stage(id, RETURN_STAGE);
+					});
 				}
 
 				//sim output
@@ -213,11 +256,11 @@ void Die::update(void){
 
 	if (!returnDataPackets.empty())
 	{
-	    if( BUFFERED == true)
+	    if(KERNEL_FLAG(buffered, BUFFERED))
 	    {
 		if(deviceBeatsLeft == 0 && sending == false){
-		    dataCyclesLeft = divide_params(DEVICE_CYCLE,CYCLE_TIME);
-		    deviceBeatsLeft = divide_params((NV_PAGE_SIZE*8192),DEVICE_WIDTH);
+		    dataCyclesLeft = device_cycles;
+		    deviceBeatsLeft = page_beats;
 		    sending = true;
 		}
 
@@ -227,12 +270,13 @@ void Die::update(void){
 		    if(success == true)
 		    {
 			deviceBeatsLeft--;
-			dataCyclesLeft = divide_params(DEVICE_CYCLE,CYCLE_TIME);
+			dataCyclesLeft = device_cycles;
 		    }
 		}
 		
-		if(dataCyclesLeft > 0 && deviceBeatsLeft == 0 && LOGGING && PLANE_STATE_LOG){
-		    log->log_plane_state(returnDataPackets.front()->package, returnDataPackets.front()->die, returnDataPackets.front()->plane, IDLE);
+		// the last piece may already have been loaded into the buffer and popped
+		if(dataCyclesLeft > 0 && deviceBeatsLeft == 0 && !returnDataPackets.empty() && KERNEL_FLAG(logging, LOGGING) && PLANE_STATE_LOG){
+		    logPlaneIdle(returnDataPackets.front());
 		}
 		
 		if(dataCyclesLeft > 0 && deviceBeatsLeft > 0){
@@ -241,15 +285,16 @@ void Die::update(void){
 	    }else{
 		if(buffer->channel->hasChannel(BUFFER, id)){
 		    if(dataCyclesLeft == 0){
-			buffer->channel->sendToController(returnDataPackets.front());
-			buffer->channel->releaseChannel(BUFFER, id);
-			if(LOGGING && PLANE_STATE_LOG)
+			// log this before sending the packet on because the controller is going to release it
+			if(KERNEL_FLAG(logging, LOGGING) && PLANE_STATE_LOG)
 			{
-			    log->log_plane_state(returnDataPackets.front()->package, returnDataPackets.front()->die, returnDataPackets.front()->plane, IDLE);
+			    logPlaneIdle(returnDataPackets.front());
 			}
+			buffer->channel->sendToController(returnDataPackets.front());
+			buffer->channel->releaseChannel(BUFFER, id);
 			returnDataPackets.pop();
 		    }
-		    if(CRIT_LINE_FIRST && dataCyclesLeft == critBeat)
+		    if(KERNEL_FLAG(crit_line_first, CRIT_LINE_FIRST) && dataCyclesLeft == critBeat)
 		    {
 			buffer->channel->controller->returnCritLine(returnDataPackets.front());
 		    }
@@ -258,13 +303,47 @@ void Die::update(void){
 		}else{
 		    if(buffer->channel->obtainChannel(id, BUFFER, NULL))
 		    {
-			dataCyclesLeft = (divide_params((NV_PAGE_SIZE*8192),DEVICE_WIDTH) * DEVICE_CYCLE) / CYCLE_TIME;
+			dataCyclesLeft = page_cycles;
 		    }
 		}
 	    }
 	}
 }
 
+// number of updates that will do nothing but count down the planes' command timers
+uint64_t Die::nextEvent(void)
+{
+	uint64_t i, next = NO_EVENT;
+
+	// data waiting to go back out needs attention every cycle
+	if (!returnDataPackets.empty())
+	{
+		return 0;
+	}
+
+	for (i = 0 ; i < PLANES_PER_DIE ; i++){
+		if (currentCommands[i] != NULL && controlCyclesLeft[i] < next){
+			next = controlCyclesLeft[i];
+		}
+	}
+
+	return next;
+}
+
+// fast forward the die, the caller must make sure cycles is no larger than nextEvent()
+void Die::skipCycles(uint64_t cycles)
+{
+	uint64_t i;
+
+	for (i = 0 ; i < PLANES_PER_DIE ; i++){
+		if (currentCommands[i] != NULL){
+			controlCyclesLeft[i] -= cycles;
+		}
+	}
+
+	currentClockCycle += cycles;
+}
+
 void Die::bufferDone(uint64_t plane)
 {
     //sanity check
@@ -286,6 +365,14 @@ void Die::bufferLoaded()
     sending = false;
 }
 
+void Die::logPlaneIdle(ChannelPacket *busPacket)
+{
+    uint64_t package = busPacket->package, die = busPacket->die, plane = busPacket->plane;
+    parentNVDIMM->packageEvent(package, [=] {
+	log->log_plane_state(package, die, plane, IDLE);
+    });
+}
+
 void Die::critLineDone()
 {
     if(CRIT_LINE_FIRST)
@@ -296,7 +383,22 @@ void Die::critLineDone()
 
 void Die::writeToPlane(ChannelPacket *packet)
 {
-	ChannelPacket *temp = new ChannelPacket(DATA, packet->virtualAddress, packet->physicalAddress, packet->page, packet->block, packet->plane, packet->die, packet->package, NULL);
+	ChannelPacket *temp = parentNVDIMM->allocatePacket(DATA, packet->id, packet->virtualAddress, packet->physicalAddress, packet->page, packet->block, packet->plane, packet->die, packet->package);
 	planes[packet->plane].storeInData(temp);
 	planes[packet->plane].write(packet);
+
+	// both packets are done now, this is only used when restoring state or fast forwarding so nothing else will free them
+	parentNVDIMM->releasePacket(temp);
+	parentNVDIMM->releasePacket(packet);
+}
+
+void Die::eraseInPlane(ChannelPacket *packet)
+{
+	planes[packet->plane].erase(packet);
+	parentNVDIMM->releasePacket(packet);
+}
+
+void Die::populatePlane(uint plane, uint block, const uint64_t *pages, uint64_t words)
+{
+	planes[plane].populate(block, pages, words);
 }
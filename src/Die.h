@@ -52,6 +52,7 @@ namespace NVDSim{
 	class Die : public SimObj{
 		public:
 	                Die(NVDIMM *parent, Logger *l, uint64_t id);
+			~Die(void);
 			void attachToBuffer(Buffer *buff);
 			void receiveFromBuffer(ChannelPacket *busPacket);
 			int isDieBusy(uint64_t plane);
@@ -60,9 +61,19 @@ namespace NVDSim{
 			void bufferDone(uint64_t plane);
 			void bufferLoaded(void);
 			void critLineDone(void);
+			void logPlaneIdle(ChannelPacket *busPacket);
+
+			// the update for this die's flags, see FlashConfiguration.h
+			template <int buffered, int logging, int crit_line_first> void updateKernel(void);
+
+			// for skipping idle cycles
+			uint64_t nextEvent(void);
+			void skipCycles(uint64_t cycles);
 
 			// for fast forwarding
 			void writeToPlane(ChannelPacket *packet);
+			void eraseInPlane(ChannelPacket *packet);
+			void populatePlane(uint plane, uint block, const uint64_t *pages, uint64_t words);
 
 		private:
 			uint64_t id;
@@ -78,6 +89,14 @@ namespace NVDSim{
 			std::vector<Plane> planes;
 			std::vector<ChannelPacket *> currentCommands;
 			uint *controlCyclesLeft;
+
+			void (Die::*update_kernel)(void);
+
+			// timing that only depends on the config, worked out once when the die is built
+			uint read_cycles, write_cycles, erase_cycles;
+			uint device_cycles; //cycles per device beat
+			uint page_beats; //device beats per page
+			uint page_cycles; //cycles to send a whole page when there is no buffer
 	};
 }
 #endif
@@ -0,0 +1,153 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//EventLog.cpp
+//class file for the binary event logs
+
+#include "EventLog.h"
+#include "FlashConfiguration.h"
+
+using namespace NVDSim;
+using namespace std;
+
+EventLog::EventLog(uint logs)
+	: ring(EVENT_LOG_ENTRIES)
+{
+	files = vector<FILE *>(logs, (FILE *)NULL);
+	stopping = false;
+}
+
+EventLog::~EventLog(void)
+{
+	close();
+}
+
+bool EventLog::isOpen(uint log)
+{
+	return files[log] != NULL;
+}
+
+void EventLog::open(uint log, string path, const EventLogHeader &header)
+{
+	if (written.count(path) != 0)
+	{
+		files[log] = fopen(path.c_str(), "ab");
+	}
+	else
+	{
+		files[log] = fopen(path.c_str(), "wb");
+		if (files[log] != NULL)
+		{
+			fwrite(&header, sizeof(header), 1, files[log]);
+		}
+		written.insert(path);
+	}
+
+	if (files[log] == NULL)
+	{
+		ERROR("Could not open event log " << path);
+		abort();
+	}
+	setvbuf(files[log], NULL, _IOFBF, 1 << 20);
+
+	if (!writer.joinable())
+	{
+		stopping = false;
+		writer = thread(&EventLog::run, this);
+	}
+}
+
+void EventLog::record(uint log, uint64_t cycle, uint32_t queue, uint32_t op, uint64_t address)
+{
+	Pending p;
+	uint64_t spins = 0;
+
+	p.record.cycle = cycle;
+	p.record.address = address;
+	p.record.queue = queue;
+	p.record.op = op;
+	p.log = log;
+
+	// the ring is full, the writer has to catch up
+	while (!ring.push(p))
+	{
+		if (++spins > 1000)
+		{
+			this_thread::yield();
+		}
+	}
+}
+
+void EventLog::close(void)
+{
+	uint64_t i;
+
+	if (writer.joinable())
+	{
+		stopping = true;
+		writer.join();
+	}
+
+	for (i = 0; i < files.size(); i++)
+	{
+		if (files[i] != NULL)
+		{
+			fclose(files[i]);
+			files[i] = NULL;
+		}
+	}
+}
+
+void EventLog::run(void)
+{
+	Pending p;
+	bool done;
+
+	while (true)
+	{
+		// stopping is checked before the ring so nothing logged before close() is missed
+		done = stopping.load(memory_order_acquire);
+		if (ring.pop(p))
+		{
+			fwrite(&p.record, sizeof(p.record), 1, files[p.log]);
+		}
+		else if (done)
+		{
+			break;
+		}
+		else
+		{
+			this_thread::sleep_for(chrono::microseconds(100));
+		}
+	}
+}
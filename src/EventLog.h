@@ -0,0 +1,124 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVEVENTLOG_H
+#define NVEVENTLOG_H
+//EventLog.h
+//header file for the binary event logs and the thread that writes them
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <atomic>
+
+#include "LockFreeQueue.h"
+
+// records held in memory waiting for the writer thread
+#define EVENT_LOG_ENTRIES (1 << 16)
+
+#define EVENT_LOG_MAGIC "NVDEVLOG"
+#define EVENT_LOG_VERSION 1
+
+// the op of the record that ends a snapshot of a queue
+#define EVENT_END 0xffffffff
+
+namespace NVDSim
+{
+	enum EventLogKind{
+		FTL_READ_QUEUE_EVENTS,
+		FTL_WRITE_QUEUE_EVENTS,
+		CTRL_READ_QUEUE_EVENTS,
+		CTRL_WRITE_QUEUE_EVENTS,
+		PLANE_STATE_EVENTS
+	};
+
+	// the start of every event log file
+	struct EventLogHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t kind; // EventLogKind
+		uint64_t number; // which controller queue this is
+		uint64_t packages, dies, planes; // the layout the plane state log is indexed with
+	};
+
+	// One event as it is stored in the file.
+	// Queue logs write a snapshot of the queue on every event, one record for each entry with the
+	// transaction or packet type as the op, then an EVENT_END record. The plane state log writes one
+	// record each time a plane changes state, with the plane's index as the queue and its new state as the op.
+	struct EventRecord
+	{
+		uint64_t cycle;
+		uint64_t address;
+		uint32_t queue;
+		uint32_t op;
+	};
+
+	// Queue and plane state events are copied into a ring in memory and a thread of its own writes them
+	// out to the log files, so logging an event never waits on the disk unless the ring fills up.
+	// Only one thread should log events. NVDLogConvert turns the files back into the text logs.
+	class EventLog
+	{
+	public:
+		EventLog(uint logs);
+		~EventLog(void);
+
+		bool isOpen(uint log);
+		// creates the file for a log, a file this has written before is added to instead
+		void open(uint log, std::string path, const EventLogHeader &header);
+		void record(uint log, uint64_t cycle, uint32_t queue, uint32_t op, uint64_t address);
+		// writes out everything logged so far and closes the files, they are opened again as needed
+		void close(void);
+
+	private:
+		// a record and the log it goes to
+		struct Pending
+		{
+			EventRecord record;
+			uint log;
+		};
+
+		void run(void);
+
+		LockFreeQueue<Pending> ring;
+		std::vector<FILE *> files;
+		std::set<std::string> written;
+		std::thread writer;
+		std::atomic<bool> stopping;
+	};
+}
+
+#endif
@@ -98,61 +98,204 @@
 #define Power_Callback 1
 #define Verbose_Power_Callback 0
 
+// Event Skipping
+// returned by nextEvent() when a component has nothing in flight and will stay idle
+// until some other part of the system hands it work
+#define NO_EVENT ((uint64_t) -1)
+
 namespace NVDSim{
 
-// Scheduling Options
-extern bool SCHEDULE;
-extern bool WRITE_ON_QUEUE_SIZE;
-extern uint WRITE_QUEUE_LIMIT;
-extern bool IDLE_WRITE;
-extern bool CTRL_SCHEDULE;
-extern bool CTRL_WRITE_ON_QUEUE_SIZE;
-extern uint CTRL_WRITE_QUEUE_LIMIT;
-extern bool CTRL_IDLE_WRITE;
-
-// Buffering Options
-extern bool BUFFERED;
-extern uint64_t IN_BUFFER_SIZE;
-extern uint64_t OUT_BUFFER_SIZE;
-
-// Critical Cache Line First Options 
-extern bool CRIT_LINE_FIRST;
-
-// Logging Options
-extern bool LOGGING;
-extern std::string LOG_DIR;
-extern bool WEAR_LEVEL_LOG;
-extern bool RUNTIME_WRITE;
-extern bool PER_PACKAGE;
-extern bool QUEUE_EVENT_LOG;
-extern bool PLANE_STATE_LOG;
-
-// Save and Restore Options
-extern bool ENABLE_NV_SAVE;
-extern std::string NV_SAVE_FILE;
-extern bool ENABLE_NV_RESTORE;
-extern std::string NV_RESTORE_FILE;
-
-extern std::string DEVICE_TYPE;
-extern uint64_t NUM_PACKAGES;
-extern uint64_t DIES_PER_PACKAGE;
-extern uint64_t PLANES_PER_DIE;
-extern uint64_t BLOCKS_PER_PLANE;
-extern uint64_t VIRTUAL_BLOCKS_PER_PLANE;
-extern uint64_t PAGES_PER_BLOCK;
-extern uint64_t NV_PAGE_SIZE;
-extern float DEVICE_CYCLE;
-extern float CHANNEL_CYCLE;
-extern uint64_t DEVICE_WIDTH;
-extern uint64_t CHANNEL_WIDTH;
-// does the device use garbage collection 
-extern bool GARBAGE_COLLECT;
+// All of the parameters read from the ini files. Every NVDIMM owns its own Config, which Init
+// fills in when the NVDIMM is constructed, so several differently configured NVDIMMs can be
+// simulated in one process. The components never name the Config directly, they read the
+// parameters through the macros below which go through config_params(). In a SimObj that is the
+// Config the object was built under, anywhere else it is current_config.
+class Config
+{
+public:
+	// Simulation Options
+	// number of threads used to update the packages, 0 or 1 updates them serially
+	uint PARALLEL_THREADS;
 
-#define GC GARBAGE_COLLECT
+	// Scheduling Options
+	bool SCHEDULE;
+	bool WRITE_ON_QUEUE_SIZE;
+	uint WRITE_QUEUE_LIMIT;
+	bool IDLE_WRITE;
+	bool CTRL_SCHEDULE;
+	bool CTRL_WRITE_ON_QUEUE_SIZE;
+	uint CTRL_WRITE_QUEUE_LIMIT;
+	bool CTRL_IDLE_WRITE;
+	uint CTRL_SCHEDULE_WINDOW; //how many packets at the front of a queue the controller can choose from
+	uint CTRL_SCHEDULE_AGE; //how many times the head of a queue can be passed over before it has to go next
+
+	// Buffering Options
+	bool BUFFERED;
+	uint64_t IN_BUFFER_SIZE;
+	uint64_t OUT_BUFFER_SIZE;
+
+	// Critical Cache Line First Options 
+	bool CRIT_LINE_FIRST;
+
+	// Logging Options
+	bool LOGGING;
+	std::string LOG_DIR;
+	bool WEAR_LEVEL_LOG;
+	bool RUNTIME_WRITE;
+	bool PER_PACKAGE;
+	bool QUEUE_EVENT_LOG;
+	bool PLANE_STATE_LOG;
+
+	// Save and Restore Options
+	bool ENABLE_NV_SAVE;
+	std::string NV_SAVE_FILE;
+	bool ENABLE_NV_RESTORE;
+	std::string NV_RESTORE_FILE;
+
+	std::string DEVICE_TYPE;
+	uint64_t NUM_PACKAGES;
+	uint64_t DIES_PER_PACKAGE;
+	uint64_t PLANES_PER_DIE;
+	// not read from the ini, Init sets it to VIRTUAL_BLOCKS_PER_PLANE * PBLOCKS_PER_VBLOCK
+	uint64_t BLOCKS_PER_PLANE;
+	uint64_t VIRTUAL_BLOCKS_PER_PLANE;
+	uint64_t PAGES_PER_BLOCK;
+	uint64_t NV_PAGE_SIZE;
+	float DEVICE_CYCLE;
+	float CHANNEL_CYCLE;
+	uint64_t DEVICE_WIDTH;
+	uint64_t CHANNEL_WIDTH;
+	// does the device use garbage collection 
+	bool GARBAGE_COLLECT;
+
+	float IDLE_GC_THRESHOLD;
+	float FORCE_GC_THRESHOLD;
+	float PBLOCKS_PER_VBLOCK;
+
+	uint READ_TIME;
+	uint WRITE_TIME;
+	uint ERASE_TIME;
+	uint COMMAND_LENGTH; //in bits, including address
+	uint LOOKUP_TIME;
+	uint FTL_LOOKUP_ENGINES; //number of transactions the ftl can be translating at once
+	uint QUEUE_ACCESS_TIME; //time it takes to read data out of the write queue
+	// in nanoseconds
+	float CYCLE_TIME;
+
+	uint EPOCH_TIME;
+	uint FTL_READ_QUEUE_LENGTH;
+	uint FTL_WRITE_QUEUE_LENGTH;
+	uint CTRL_READ_QUEUE_LENGTH;
+	uint CTRL_WRITE_QUEUE_LENGTH;
 
-extern float IDLE_GC_THRESHOLD;
-extern float FORCE_GC_THRESHOLD;
-extern float PBLOCKS_PER_VBLOCK;
+	// Power stuff
+	double READ_I;
+	double WRITE_I;
+	double ERASE_I;
+	double STANDBY_I;
+	double IN_LEAK_I;
+	double OUT_LEAK_I;
+	double VCC;
+
+	// PCM specific power stuff
+	double ASYNC_READ_I;
+	double VPP_STANDBY_I;
+	double VPP_READ_I;
+	double VPP_WRITE_I;
+	double VPP_ERASE_I;
+	double VPP;
+};
+
+// the Config of the NVDIMM that this thread is currently simulating
+// NVDIMM installs its own Config with a ConfigScope on every call into it and its worker threads
+// install it when they start, so nothing outside of Init and NVDIMM should ever change this
+extern thread_local const Config *current_config;
+
+class ConfigScope
+{
+public:
+	ConfigScope(const Config *config) { previous = current_config; current_config = config; }
+	~ConfigScope() { current_config = previous; }
+private:
+	const Config *previous;
+};
+
+// code that isn't part of a SimObj gets the current thread's Config, see SimObj.h
+inline const Config *config_params(void) { return current_config; }
+
+// Init fills in the members of a Config by name so it needs them without these macros
+#ifndef NO_CONFIG_MACROS
+#define PARALLEL_THREADS (config_params()->PARALLEL_THREADS)
+#define SCHEDULE (config_params()->SCHEDULE)
+#define WRITE_ON_QUEUE_SIZE (config_params()->WRITE_ON_QUEUE_SIZE)
+#define WRITE_QUEUE_LIMIT (config_params()->WRITE_QUEUE_LIMIT)
+#define IDLE_WRITE (config_params()->IDLE_WRITE)
+#define CTRL_SCHEDULE (config_params()->CTRL_SCHEDULE)
+#define CTRL_WRITE_ON_QUEUE_SIZE (config_params()->CTRL_WRITE_ON_QUEUE_SIZE)
+#define CTRL_WRITE_QUEUE_LIMIT (config_params()->CTRL_WRITE_QUEUE_LIMIT)
+#define CTRL_IDLE_WRITE (config_params()->CTRL_IDLE_WRITE)
+#define CTRL_SCHEDULE_WINDOW (config_params()->CTRL_SCHEDULE_WINDOW)
+#define CTRL_SCHEDULE_AGE (config_params()->CTRL_SCHEDULE_AGE)
+#define BUFFERED (config_params()->BUFFERED)
+#define IN_BUFFER_SIZE (config_params()->IN_BUFFER_SIZE)
+#define OUT_BUFFER_SIZE (config_params()->OUT_BUFFER_SIZE)
+#define CRIT_LINE_FIRST (config_params()->CRIT_LINE_FIRST)
+#define LOGGING (config_params()->LOGGING)
+#define LOG_DIR (config_params()->LOG_DIR)
+#define WEAR_LEVEL_LOG (config_params()->WEAR_LEVEL_LOG)
+#define RUNTIME_WRITE (config_params()->RUNTIME_WRITE)
+#define PER_PACKAGE (config_params()->PER_PACKAGE)
+#define QUEUE_EVENT_LOG (config_params()->QUEUE_EVENT_LOG)
+#define PLANE_STATE_LOG (config_params()->PLANE_STATE_LOG)
+#define ENABLE_NV_SAVE (config_params()->ENABLE_NV_SAVE)
+#define NV_SAVE_FILE (config_params()->NV_SAVE_FILE)
+#define ENABLE_NV_RESTORE (config_params()->ENABLE_NV_RESTORE)
+#define NV_RESTORE_FILE (config_params()->NV_RESTORE_FILE)
+#define DEVICE_TYPE (config_params()->DEVICE_TYPE)
+#define NUM_PACKAGES (config_params()->NUM_PACKAGES)
+#define DIES_PER_PACKAGE (config_params()->DIES_PER_PACKAGE)
+#define PLANES_PER_DIE (config_params()->PLANES_PER_DIE)
+#define BLOCKS_PER_PLANE (config_params()->BLOCKS_PER_PLANE)
+#define VIRTUAL_BLOCKS_PER_PLANE (config_params()->VIRTUAL_BLOCKS_PER_PLANE)
+#define PAGES_PER_BLOCK (config_params()->PAGES_PER_BLOCK)
+#define NV_PAGE_SIZE (config_params()->NV_PAGE_SIZE)
+#define DEVICE_CYCLE (config_params()->DEVICE_CYCLE)
+#define CHANNEL_CYCLE (config_params()->CHANNEL_CYCLE)
+#define DEVICE_WIDTH (config_params()->DEVICE_WIDTH)
+#define CHANNEL_WIDTH (config_params()->CHANNEL_WIDTH)
+#define GARBAGE_COLLECT (config_params()->GARBAGE_COLLECT)
+#define IDLE_GC_THRESHOLD (config_params()->IDLE_GC_THRESHOLD)
+#define FORCE_GC_THRESHOLD (config_params()->FORCE_GC_THRESHOLD)
+#define PBLOCKS_PER_VBLOCK (config_params()->PBLOCKS_PER_VBLOCK)
+#define READ_TIME (config_params()->READ_TIME)
+#define WRITE_TIME (config_params()->WRITE_TIME)
+#define ERASE_TIME (config_params()->ERASE_TIME)
+#define COMMAND_LENGTH (config_params()->COMMAND_LENGTH)
+#define LOOKUP_TIME (config_params()->LOOKUP_TIME)
+#define FTL_LOOKUP_ENGINES (config_params()->FTL_LOOKUP_ENGINES)
+#define QUEUE_ACCESS_TIME (config_params()->QUEUE_ACCESS_TIME)
+#define CYCLE_TIME (config_params()->CYCLE_TIME)
+#define EPOCH_TIME (config_params()->EPOCH_TIME)
+#define FTL_READ_QUEUE_LENGTH (config_params()->FTL_READ_QUEUE_LENGTH)
+#define FTL_WRITE_QUEUE_LENGTH (config_params()->FTL_WRITE_QUEUE_LENGTH)
+#define CTRL_READ_QUEUE_LENGTH (config_params()->CTRL_READ_QUEUE_LENGTH)
+#define CTRL_WRITE_QUEUE_LENGTH (config_params()->CTRL_WRITE_QUEUE_LENGTH)
+#define READ_I (config_params()->READ_I)
+#define WRITE_I (config_params()->WRITE_I)
+#define ERASE_I (config_params()->ERASE_I)
+#define STANDBY_I (config_params()->STANDBY_I)
+#define IN_LEAK_I (config_params()->IN_LEAK_I)
+#define OUT_LEAK_I (config_params()->OUT_LEAK_I)
+#define VCC (config_params()->VCC)
+#define ASYNC_READ_I (config_params()->ASYNC_READ_I)
+#define VPP_STANDBY_I (config_params()->VPP_STANDBY_I)
+#define VPP_READ_I (config_params()->VPP_READ_I)
+#define VPP_WRITE_I (config_params()->VPP_WRITE_I)
+#define VPP_ERASE_I (config_params()->VPP_ERASE_I)
+#define VPP (config_params()->VPP)
+#endif
+
+#define GC GARBAGE_COLLECT
 
 #define BLOCK_SIZE (NV_PAGE_SIZE * PAGES_PER_BLOCK)
 #define PLANE_SIZE (NV_PAGE_SIZE * BLOCKS_PER_PLANE * PAGES_PER_BLOCK)
@@ -165,38 +308,16 @@ extern float PBLOCKS_PER_VBLOCK;
 #define VIRTUAL_PACKAGE_SIZE (NV_PAGE_SIZE * DIES_PER_PACKAGE * PLANES_PER_DIE * VIRTUAL_BLOCKS_PER_PLANE * PAGES_PER_BLOCK)
 #define VIRTUAL_TOTAL_SIZE (NV_PAGE_SIZE * NUM_PACKAGES * DIES_PER_PACKAGE * PLANES_PER_DIE * VIRTUAL_BLOCKS_PER_PLANE * PAGES_PER_BLOCK)
 
-extern uint READ_TIME;
-extern uint WRITE_TIME;
-extern uint ERASE_TIME;
-extern uint COMMAND_LENGTH; //in bits, including address
-extern uint LOOKUP_TIME;
-extern uint QUEUE_ACCESS_TIME; //time it takes to read data out of the write queue
-// in nanoseconds
-extern float CYCLE_TIME;
-
-extern uint EPOCH_TIME;
 #define USE_EPOCHS (EPOCH_TIME > 0)
-extern uint FTL_READ_QUEUE_LENGTH;
-extern uint FTL_WRITE_QUEUE_LENGTH;
-extern uint CTRL_READ_QUEUE_LENGTH;
-extern uint CTRL_WRITE_QUEUE_LENGTH;
-
-// Power stuff
-extern double READ_I;
-extern double WRITE_I;
-extern double ERASE_I;
-extern double STANDBY_I;
-extern double IN_LEAK_I;
-extern double OUT_LEAK_I;
-extern double VCC;
-
-// PCM specific power stuff
-extern double ASYNC_READ_I;
-extern double VPP_STANDBY_I;
-extern double VPP_READ_I;
-extern double VPP_WRITE_I;
-extern double VPP_ERASE_I;
-extern double VPP;
+
+// Update Kernels
+// The updates that run for every package or die on every cycle are templates on the mode flags they
+// branch on and each component picks the instantiation for its config when it is built, so in the
+// common case the flags are constants and the code for the modes that are off is compiled out.
+// A flag given as RUNTIME_FLAG is read from the config instead, that is the generic kernel and
+// building with -DGENERIC_KERNELS makes everything use it.
+#define RUNTIME_FLAG -1
+#define KERNEL_FLAG(param, flag) ((param) < 0 ? (bool)(flag) : (param) > 0)
 
 extern uint OUTPUT;
 
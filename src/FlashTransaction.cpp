@@ -47,6 +47,15 @@ FlashTransaction::FlashTransaction(){}
 FlashTransaction::FlashTransaction(TransactionType transType, uint64_t addr, void *dat)
 {
 	transactionType = transType;
+	id = 0;
+	address = addr;
+	data = dat;
+}
+
+FlashTransaction::FlashTransaction(TransactionType transType, uint64_t transId, uint64_t addr, void *dat)
+{
+	transactionType = transType;
+	id = transId;
 	address = addr;
 	data = dat;
 }
@@ -55,15 +64,15 @@ void FlashTransaction::print()
 {
 	if(transactionType == DATA_READ)
 		{
-			PRINT("T [Read] [0x" << hex << address << "]" << dec );
+			PRINT("T [Read] [" << id << "] [0x" << hex << address << "]" << dec );
 		}
 	else if(transactionType == DATA_WRITE)
 		{
-			PRINT("T [Write] [0x" << hex << address << "] [" << dec << data << "]" );
+			PRINT("T [Write] [" << id << "] [0x" << hex << address << "] [" << dec << data << "]" );
 		}
 	else if(transactionType == RETURN_DATA)
 		{
-			PRINT("T [Data] [0x" << hex << address << "] [" << dec << data << "]" );
+			PRINT("T [Data] [" << id << "] [0x" << hex << address << "] [" << dec << data << "]" );
 		}
 }
 
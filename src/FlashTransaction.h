@@ -60,6 +60,7 @@ namespace NVDSim
 	public:
 		//fields
 		TransactionType transactionType;
+		uint64_t id; // given out by the NVDIMM when the request is accepted, unique while it is in flight
 		uint64_t address;
 		void *data;
 		uint64_t timeAdded;
@@ -68,6 +69,7 @@ namespace NVDSim
 		
 		//functions
 		FlashTransaction(TransactionType transType, uint64_t addr, void *data);
+		FlashTransaction(TransactionType transType, uint64_t id, uint64_t addr, void *data);
 		FlashTransaction();
 		
 		void print();
@@ -55,13 +55,22 @@ Ftl::Ftl(Controller *c, Logger *l, NVDIMM *p){
 	channel = 0;
 	die = 0;
 	plane = 0;
-	lookupCounter = 0;
 
-	busy = 0;
+	engines = vector<LookupEngine>(FTL_LOOKUP_ENGINES > 0 ? FTL_LOOKUP_ENGINES : 1);
+	current = &engines[0];
 
-	addressMap = std::unordered_map<uint64_t, uint64_t>();
+	used = PageBitmap(numBlocks, PAGES_PER_BLOCK);
+	used_page_count = 0;
 
-	used = vector<vector<bool>>(numBlocks, vector<bool>(PAGES_PER_BLOCK, false));
+	reverseMap = vector<uint64_t>(numBlocks * PAGES_PER_BLOCK, NO_MAPPING);
+
+	uint64_t numPlanes = NUM_PACKAGES * DIES_PER_PACKAGE * PLANES_PER_DIE;
+	free_blocks = vector<deque<uint64_t> >(numPlanes, deque<uint64_t>());
+	active_block = vector<uint64_t>(numPlanes, NO_ACTIVE_BLOCK);
+	next_page = vector<uint64_t>(numPlanes, 0);
+	block_queued = vector<bool>(numBlocks, false);
+	block_retired = vector<bool>(numBlocks, false);
+	build_free_lists();
 
 	readQueue = list<FlashTransaction>();
 	writeQueue = list<FlashTransaction>();
@@ -74,19 +83,11 @@ Ftl::Ftl(Controller *c, Logger *l, NVDIMM *p){
 	
 	saved = false;
 	loaded = false;
-	queues_full = false;
 
 	// Counter to keep track of succesful writes.
 	write_counter = 0;
 
-	// Counter to keep track of how long we've been access data in the write queue
-	queue_access_counter = 0;
-
-	// Counter to keep track of cycles we spend waiting on erases
-	// if we wait longer than the length of an erase, we've probably deadlocked
-	deadlock_counter = 0;
-
-	// the maximum amount of time we can wait before we're sure we've deadlocked
+	// the maximum amount of time an engine can wait on erases for a free page before we're sure we've deadlocked
 	// time it takes to read all of the pages in a block
 	deadlock_time = PAGES_PER_BLOCK * (READ_TIME + ((divide_params((NV_PAGE_SIZE*8192),DEVICE_WIDTH) * DEVICE_CYCLE) / CYCLE_TIME) +
 					   ((divide_params(COMMAND_LENGTH,DEVICE_WIDTH) * DEVICE_CYCLE) / CYCLE_TIME));
@@ -97,7 +98,7 @@ Ftl::Ftl(Controller *c, Logger *l, NVDIMM *p){
 	deadlock_time += ERASE_TIME + ((divide_params(COMMAND_LENGTH,DEVICE_WIDTH) * DEVICE_CYCLE) / CYCLE_TIME);
 }
 
-ChannelPacket *Ftl::translate(ChannelPacketType type, uint64_t vAddr, uint64_t pAddr){
+ChannelPacket *Ftl::translate(ChannelPacketType type, uint64_t id, uint64_t vAddr, uint64_t pAddr){
 
 	uint package, die, plane, block, page;
 	//uint64_t tempA, tempB, physicalAddress = pAddr;
@@ -146,7 +147,7 @@ ChannelPacket *Ftl::translate(ChannelPacketType type, uint64_t vAddr, uint64_t p
 	  tempB = physicalAddress << packageBitWidth;
 	  package = tempA ^ tempB;
 	 */
-	return new ChannelPacket(type, vAddr, pAddr, page, block, plane, die, package, NULL);
+	return parent->allocatePacket(type, id, vAddr, pAddr, page, block, plane, die, package);
 }
 
 bool Ftl::addTransaction(FlashTransaction &t){
@@ -165,11 +166,12 @@ bool Ftl::addTransaction(FlashTransaction &t){
 		else
 		{
 		    readQueue.push_back(t);
+		    sendQueueLength();
 		    
 		    if(LOGGING)
 		    {
 			// Start the logging for this access.
-			log->access_start(t.address);
+			log->access_start(t.id);
 			if(QUEUE_EVENT_LOG)
 			{
 			    log->log_ftl_queue_event(false, &readQueue);
@@ -188,23 +190,22 @@ bool Ftl::addTransaction(FlashTransaction &t){
 		{
 		    // see if this write replaces another already in the write queue
 		    // if it does remove that other write from the queue
+		    // a write that is being looked up can't be replaced, both of them go to the device
 		    list<FlashTransaction>::iterator it;
 		    for (it = writeQueue.begin(); it != writeQueue.end(); it++)
 		    {
-			if((*it).address == t.address)
+			if((*it).address == t.address && !in_lookup(it))
 			{
 			    if(LOGGING)
 			    {
 				// access_process for that write is called here since its over now.
-				log->access_process(t.address, t.address, 0, WRITE);
+				log->access_process((*it).id, t.address, 0, WRITE);
 
 				// stop_process for that write is called here since its over now.
-				log->access_stop(t.address, t.address);
+				log->access_stop((*it).id);
 			    }
 			    // issue a callback for this write
-			    if (parent->WriteDataDone != NULL){
-				(*parent->WriteDataDone)(parent->systemID, (*it).address, currentClockCycle, true);
-			    }
+			    parent->writeDone((*it).id, (*it).address, currentClockCycle);
 			    writeQueue.erase(it);
 			    break;
 			}
@@ -214,7 +215,7 @@ bool Ftl::addTransaction(FlashTransaction &t){
 		    if(LOGGING)
 		    {
 			// Start the logging for this access.
-			log->access_start(t.address);
+			log->access_start(t.id);
 			if(QUEUE_EVENT_LOG)
 			{
 			    log->log_ftl_queue_event(true, &writeQueue);
@@ -235,11 +236,12 @@ bool Ftl::addTransaction(FlashTransaction &t){
 	    else
 	    {
 		readQueue.push_back(t);
+		sendQueueLength();
 		
 		if(LOGGING)
 		{
 		    // Start the logging for this access.
-		    log->access_start(t.address);
+		    log->access_start(t.id);
 		    if(QUEUE_EVENT_LOG)
 		    {
 			log->log_ftl_queue_event(false, &readQueue);
@@ -254,92 +256,271 @@ bool Ftl::addTransaction(FlashTransaction &t){
     exit(5001);
 }
 
+// Fast forward transactions are done right away without any timing. Writes update the address map, the page
+// state and the planes the same way a simulated write would so the detailed simulation can pick up from
+// wherever the fast forward leaves off. Reads don't change anything so there's nothing to do for them.
+// This should only be used while there is nothing in the queues.
 void Ftl::addFfTransaction(FlashTransaction &t){ 
+	if (t.address >= (VIRTUAL_TOTAL_SIZE*1024))
+	{
+		ERROR("Tried to fast forward a transaction with a virtual address that was out of bounds");
+		exit(5001);
+	}
 
+	if (t.transactionType == DATA_WRITE)
+	{
+		if (!ff_write(t.address))
+		{
+			ERROR("FLASH DIMM IS COMPLETELY FULL - there is no room left to fast forward a write.");
+			exit(9001);
+		}
+	}
+	else if (t.transactionType != DATA_READ)
+	{
+		ERROR("Only reads and writes can be fast forwarded");
+		exit(5002);
+	}
+}
+
+// returns false if there was no free page to put the data in
+bool Ftl::ff_write(uint64_t vAddr){
+	uint64_t block, page, pAddr;
+
+	if (!find_free_page(&block, &page))
+	{
+		return false;
+	}
+	pAddr = (block * BLOCK_SIZE + page * NV_PAGE_SIZE);
+
+	unmap_page(vAddr);
+	map_page(vAddr, block, page);
+	inc_ptr();
+
+	// put the data in the plane directly
+	controller->writeToPackage(Ftl::translate(WRITE, 0, vAddr, pAddr));
+
+	return true;
 }
 
 void Ftl::update(void){
-	if (busy) {
-	    if (lookupCounter <= 0 && !queues_full){
+	uint i;
 
-			switch (currentTransaction.transactionType){
-				case DATA_READ:
-					handle_read(false);
-					break;
+	for (i = 0; i < engines.size(); i++) {
+		current = &engines[i];
 
-				case DATA_WRITE: 
-					handle_write(false);
-					break;
+		if (current->busy) {
+		    if (current->lookupCounter <= 0 && !current->queues_full){
 
-				default:
-					ERROR("FTL received an illegal transaction type:" << currentTransaction.transactionType);
-					break;
+				switch ((*current->position).transactionType){
+					case DATA_READ:
+						handle_read(false);
+						break;
+
+					case DATA_WRITE: 
+						handle_write(false);
+						break;
+
+					default:
+						ERROR("FTL received an illegal transaction type:" << (*current->position).transactionType);
+						break;
+				}
+			} //if lookupCounter is not 0
+			else if(current->lookupCounter > 0)
+			{
+				current->lookupCounter--;
 			}
-		} //if lookupCounter is not 0
-		else if(lookupCounter > 0)
+		} // Not currently busy.
+		else {
+		    // we're favoring reads over writes so we need to check the write queues to make sure they
+		    // aren't filling up. if they are we issue a write, otherwise we just keeo on issuing reads
+		    if(SCHEDULE)
+		    {
+			// do we need to issue a write?
+			if(((WRITE_ON_QUEUE_SIZE == true && queued_writes() >= WRITE_QUEUE_LIMIT) ||
+			    (WRITE_ON_QUEUE_SIZE == false && queued_writes() >= FTL_WRITE_QUEUE_LENGTH)) &&
+			   start_lookup(writeQueue))
+			{
+			}
+			// no? then issue a read
+			else if (!start_lookup(readQueue))
+			{
+			    // no reads to issue? then issue a write if we have opted to issue writes during idle
+			    if(IDLE_WRITE == true)
+			    {
+				start_lookup(writeQueue);
+			    }
+			}
+		    }
+		    // we're not scheduling so everything is in the read queue
+		    // just issue from there
+		    else
+		    {
+			start_lookup(readQueue);
+		    }
+		}
+	}
+}
+
+// Give the current engine the first transaction in the queue that can be looked up now. A transaction
+// waits while another one to the same address is being looked up so requests to an address stay in order.
+bool Ftl::start_lookup(std::list<FlashTransaction> &queue){
+	list<FlashTransaction>::iterator it;
+
+	for (it = queue.begin(); it != queue.end(); it++)
+	{
+		if (!lookup_conflict((*it).address))
 		{
-			lookupCounter--;
+			current->queue = &queue;
+			current->position = it;
+			current->lookupCounter = LOOKUP_TIME;
+			current->busy = true;
+			if (LOGGING)
+			{
+				log->access_stage((*it).id, LOOKUP_STAGE);
+			}
+			return true;
 		}
-	} // Not currently busy.
-	else {
-	    // we're favoring reads over writes so we need to check the write queues to make sure they
-	    // aren't filling up. if they are we issue a write, otherwise we just keeo on issuing reads
-	    if(SCHEDULE)
-	    {
-		// do we need to issue a write?
-		if((WRITE_ON_QUEUE_SIZE == true && writeQueue.size() >= WRITE_QUEUE_LIMIT) ||
-		   (WRITE_ON_QUEUE_SIZE == false && writeQueue.size() >= FTL_WRITE_QUEUE_LENGTH))
+	}
+	return false;
+}
+
+bool Ftl::lookup_conflict(uint64_t vAddr){
+	uint i;
+
+	for (i = 0; i < engines.size(); i++)
+	{
+		if (engines[i].busy && (*engines[i].position).address == vAddr)
+			return true;
+	}
+	return false;
+}
+
+// is there anything in the queue that start_lookup would take
+bool Ftl::lookup_ready(std::list<FlashTransaction> &queue){
+	list<FlashTransaction>::iterator it;
+
+	for (it = queue.begin(); it != queue.end(); it++)
+	{
+		if (!lookup_conflict((*it).address))
+			return true;
+	}
+	return false;
+}
+
+// is this write being looked up
+bool Ftl::in_lookup(std::list<FlashTransaction>::iterator it){
+	uint i;
+
+	for (i = 0; i < engines.size(); i++)
+	{
+		if (engines[i].busy && engines[i].queue == &writeQueue && engines[i].position == it)
+			return true;
+	}
+	return false;
+}
+
+bool Ftl::idle_engine(void){
+	uint i;
+
+	for (i = 0; i < engines.size(); i++)
+	{
+		if (!engines[i].busy)
+			return true;
+	}
+	return false;
+}
+
+// the writes that are not already being looked up, so the engines don't all jump on a full write queue
+uint64_t Ftl::queued_writes(void){
+	uint i;
+	uint64_t writes = writeQueue.size();
+
+	for (i = 0; i < engines.size(); i++)
+	{
+		if (engines[i].busy && engines[i].queue == &writeQueue)
+			writes--;
+	}
+	return writes;
+}
+
+// number of updates until one of the busy engines has something to do
+uint64_t Ftl::lookup_event(void){
+	uint i;
+	uint64_t next = NO_EVENT;
+
+	for (i = 0; i < engines.size(); i++)
+	{
+		if (!engines[i].busy)
+			continue;
+
+		if (engines[i].lookupCounter > 0)
 		{
-		    busy = 1;
-		    currentTransaction = writeQueue.front();
-		    lookupCounter = LOOKUP_TIME;
+			if (engines[i].lookupCounter < next)
+				next = engines[i].lookupCounter;
 		}
-		// no? then issue a read
-		else
+		// unless it is waiting for the controller to tell us there is room again
+		else if (!engines[i].queues_full)
 		{
-		    if (!readQueue.empty()) {
-			busy = 1;
-			currentTransaction = readQueue.front();
-			lookupCounter = LOOKUP_TIME;
-		    }
-		    // no reads to issue? then issue a write if we have opted to issue writes during idle
-		    else if(IDLE_WRITE == true && !writeQueue.empty())
-		    {
-			busy = 1;
-			currentTransaction = writeQueue.front();
-			lookupCounter = LOOKUP_TIME;
-		    }
+			return 0;
 		}
-	    }
-	    // we're not scheduling so everything is in the read queue
-	    // just issue from there
-	    else
-	    {
-		if (!readQueue.empty()) {
-		    busy = 1;
-		    currentTransaction = readQueue.front();
-		    lookupCounter = LOOKUP_TIME;
+	}
+	return next;
+}
+
+// number of updates that will only count down the current lookups
+uint64_t Ftl::nextEvent(void){
+	uint64_t next = lookup_event();
+
+	if (next == 0 || !idle_engine())
+		return next;
+
+	if (SCHEDULE)
+	{
+		if (((WRITE_ON_QUEUE_SIZE == true && queued_writes() >= WRITE_QUEUE_LIMIT) ||
+		     (WRITE_ON_QUEUE_SIZE == false && queued_writes() >= FTL_WRITE_QUEUE_LENGTH) ||
+		     IDLE_WRITE == true) && lookup_ready(writeQueue))
+		{
+			return 0;
 		}
-	    }
 	}
+
+	if (lookup_ready(readQueue))
+		return 0;
+
+	return next;
+}
+
+// fast forward the ftl, the caller must make sure cycles is no larger than nextEvent()
+void Ftl::skipCycles(uint64_t cycles){
+	uint i;
+
+	for (i = 0; i < engines.size(); i++)
+	{
+		if (engines[i].busy && engines[i].lookupCounter > 0)
+			engines[i].lookupCounter -= cycles;
+	}
+
+	currentClockCycle += cycles;
 }
 
 void Ftl::handle_read(bool gc)
 {
     ChannelPacket *commandPacket;
-    uint64_t vAddr = currentTransaction.address;
+    uint64_t id = (*current->position).id, vAddr = (*current->position).address, pAddr;
     bool write_queue_handled = false;
     
     //Check to see if the vAddr corresponds to the write waiting in the write queue
     if(!gc && SCHEDULE)
     {
-	if(queue_access_counter == 0)
+	if(current->queue_access_counter == 0)
 	{
-	    for (reading_write = writeQueue.begin(); reading_write != writeQueue.end(); reading_write++)
+	    list<FlashTransaction>::iterator it;
+	    for (it = writeQueue.begin(); it != writeQueue.end(); it++)
 	    {
-		if((*reading_write).address == vAddr)
+		if((*it).address == vAddr)
 		{
-		    queue_access_counter = QUEUE_ACCESS_TIME;
+		    current->queue_access_counter = QUEUE_ACCESS_TIME;
+		    current->queue_data = (*it).data;
 		    write_queue_handled = true;
 		    if(LOGGING)
 		    {
@@ -348,38 +529,35 @@ void Ftl::handle_read(bool gc)
 			log->read_mapped();
 
 			// access_process for this read is called here since it starts here
-			log->access_process(vAddr, vAddr, 0, READ);
+			log->access_process(id, vAddr, 0, READ);
 		    }
 		    break;
 		}
 	    }
 	}
-	else if(queue_access_counter > 0)
+	else if(current->queue_access_counter > 0)
 	{
-	    queue_access_counter--;
+	    current->queue_access_counter--;
 	    write_queue_handled = true;
-	    if(queue_access_counter == 0)
+	    if(current->queue_access_counter == 0)
 	    {
 		if(LOGGING)
 		{
 		    // stop_process for this read is called here since this ends now.
-		    log->access_stop(vAddr, vAddr);
+		    log->access_stop(id);
 		}
 
-		controller->returnReadData(FlashTransaction(RETURN_DATA, vAddr, (*reading_write).data));
-		readQueue.pop_front();
-		if(LOGGING && QUEUE_EVENT_LOG)
-		{
-		    log->log_ftl_queue_event(false, &readQueue);
-		}
-		busy = 0;
+		controller->returnReadData(FlashTransaction(RETURN_DATA, id, vAddr, current->queue_data));
+		pop_transaction();
+		current->busy = false;
 	    }
 	}
     }
     if(!write_queue_handled)
     {
         // Check to see if the vAddr exists in the address map.
-	if (addressMap.find(vAddr) == addressMap.end())
+	pAddr = addressMap.lookup(vAddr);
+	if (pAddr == NO_MAPPING)
 	{
 		if (gc)
 		{
@@ -396,14 +574,14 @@ void Ftl::handle_read(bool gc)
 			log->read_unmapped();
 
 			// access_process for this read is called here since this ends now.
-			log->access_process(vAddr, vAddr, 0, READ);
+			log->access_process(id, vAddr, 0, READ);
 
 			// stop_process for this read is called here since this ends now.
-			log->access_stop(vAddr, vAddr);
+			log->access_stop(id);
 		}
 
 		// Miss, nothing to read so return garbage.
-		controller->returnUnmappedData(FlashTransaction(RETURN_DATA, vAddr, (void *)0xdeadbeef));
+		controller->returnUnmappedData(FlashTransaction(RETURN_DATA, id, vAddr, (void *)0xdeadbeef));
 		if(gc)
 		{
 		    ERROR("GC tried to read upmapped data at address " << vAddr);
@@ -411,9 +589,9 @@ void Ftl::handle_read(bool gc)
 		}
 		else
 		{
-		    popFront(READ);
+		    pop_transaction();
 		}
-		busy = 0;
+		current->busy = false;
 	} 
 	else 
 	{					       
@@ -422,7 +600,7 @@ void Ftl::handle_read(bool gc)
 			read_type = GC_READ;
 		else
 			read_type = READ;
-		commandPacket = Ftl::translate(read_type, vAddr, addressMap[vAddr]);
+		commandPacket = Ftl::translate(read_type, id, vAddr, pAddr);
 
 		//send the read to the controller
 		bool result = controller->addPacket(commandPacket);
@@ -433,14 +611,14 @@ void Ftl::handle_read(bool gc)
 				// Update the logger (but not for GC_READ).
 				log->read_mapped();
 			}
-			popFront(read_type);
-			busy = 0;
+			pop_transaction();
+			current->busy = false;
 		}
 		else
 		{
-			// Delete the packet if it is not being used to prevent memory leaks.
-			delete commandPacket;
-			queues_full = true;
+			// Give the packet back since it is not being used.
+			parent->releasePacket(commandPacket);
+			current->queues_full = true;
 		}
 	}
     }
@@ -450,7 +628,8 @@ void Ftl::write_used_handler(uint64_t vAddr)
 {
 		// we're going to write this data somewhere else for wear-leveling purposes however we will probably 
 		// want to reuse this block for something at some later time so mark it as unused because it is
-		used[addressMap[vAddr] / BLOCK_SIZE][(addressMap[vAddr] / NV_PAGE_SIZE) % PAGES_PER_BLOCK] = false;
+		uint64_t pAddr = addressMap.lookup(vAddr);
+		free_page(pAddr / BLOCK_SIZE, (pAddr / NV_PAGE_SIZE) % PAGES_PER_BLOCK);
 
 		//cout << "USING FTL's WRITE_USED_HANDLER!!!\n";
 }
@@ -458,72 +637,29 @@ void Ftl::write_used_handler(uint64_t vAddr)
 
 void Ftl::handle_write(bool gc)
 {
-	uint64_t start;
-	uint64_t vAddr = currentTransaction.address, pAddr;
+	uint64_t id = (*current->position).id, vAddr = (*current->position).address, pAddr;
 	ChannelPacket *commandPacket, *dataPacket;
 	bool done = false;
 
 	// Mapped is used to indicate to the logger that a write was mapped or unmapped.
 	bool mapped = false;
 
-	if (addressMap.find(vAddr) != addressMap.end())
-	{
-		write_used_handler(vAddr);
-
-		mapped = true;
-	}
+	mapped = unmap_page(vAddr);
 
-	//look for first free physical page starting at the write pointer
-	start = BLOCKS_PER_PLANE * (plane + PLANES_PER_DIE * (die + DIES_PER_PACKAGE * channel));
-	uint64_t block, page, tmp_block, tmp_page;
-
-	// Search from the current write pointer to the end of the flash for a free page.
-	for (block = start ; block < TOTAL_SIZE / BLOCK_SIZE && !done; block++)
+	// get a free physical page, starting with the plane the write pointer is on
+	uint64_t block, page;
+	done = find_free_page(&block, &page);
+	if (done)
 	{
-		for (page = 0 ; page < PAGES_PER_BLOCK  && !done ; page++)
-		{
-			if (!used[block][page])
-			{
-				tmp_block = block;
-				tmp_page = page;
-				pAddr = (block * BLOCK_SIZE + page * NV_PAGE_SIZE);
-				done = true;
-			}
-		}
+		pAddr = (block * BLOCK_SIZE + page * NV_PAGE_SIZE);
 	}
-	block = tmp_block;
-	page = tmp_page;
-	//cout << "outside: " << block << "/" << page << "\n";
-	//attemptWrite(start, &vAddr, &pAddr, &done);
 
-
-	// If we didn't find a free page after scanning to the end. Scan from the beginning
-	// to the write pointer
 	if (!done)
 	{
-		//attemptWrite(0, &vAddr, &pAddr, &done);							
-
-		for (block = 0 ; block < start / BLOCK_SIZE && !done; block++)
-		{
-			for (page = 0 ; page < PAGES_PER_BLOCK  && !done; page++)
-			{
-				if (!used[block][page])
-				{
-					tmp_block = block;
-					tmp_page = page;
-					pAddr = (block * BLOCK_SIZE + page * NV_PAGE_SIZE);
-					done = true;
-				}
-			}
-		}
-		block = tmp_block;
-		page = tmp_page;
-	}
-
-	if (!done)
-	{
-	    deadlock_counter++;
-	    if(deadlock_counter == deadlock_time)
+	    // each engine keeps its own count so other engines waiting (or finding pages) in the
+	    // same cycles don't change how long this one has been stuck
+	    current->deadlock_counter++;
+	    if(current->deadlock_counter == deadlock_time)
 	    {
 		//bad news
 		cout << deadlock_time;
@@ -536,7 +672,7 @@ void Ftl::handle_write(bool gc)
 		// We've found a used page. Now we need to try to add the transaction to the Controller queue.
 	       
 	        // first things first, we're no longer in danger of dead locking so reset the counter
-	        deadlock_counter = 0;
+	        current->deadlock_counter = 0;
 
 		//send write to controller
 		
@@ -545,19 +681,18 @@ void Ftl::handle_write(bool gc)
 			write_type = GC_WRITE;
 		else
 			write_type = WRITE;
-		dataPacket = Ftl::translate(DATA, vAddr, pAddr);
-		commandPacket = Ftl::translate(write_type, vAddr, pAddr);
+		dataPacket = Ftl::translate(DATA, id, vAddr, pAddr);
+		commandPacket = Ftl::translate(write_type, id, vAddr, pAddr);
 
 		// Check to see if there is enough room for both packets in the queue (need two open spots).
 		bool queue_open = controller->checkQueueWrite(dataPacket);
 
 		if (!queue_open)
 		{
-			// These packets are not being used. Since they were dynamically allocated, we must delete them to prevent
-			// memory leaks.
-			delete dataPacket;
-			delete commandPacket;
-			queues_full = true;
+			// These packets are not being used so give them back to the pool.
+			parent->releasePacket(dataPacket);
+			parent->releasePacket(commandPacket);
+			current->queues_full = true;
 		}
 
 		if (queue_open)
@@ -570,22 +705,16 @@ void Ftl::handle_write(bool gc)
 			// Successfully added transaction to the controller queue.
 
 			//update "write pointer"
-			channel = (channel + 1) % NUM_PACKAGES;
-			if (channel == 0){
-				die = (die + 1) % DIES_PER_PACKAGE;
-				if (die == 0)
-					plane = (plane + 1) % PLANES_PER_DIE;
-			}
+			inc_ptr();
 
-			// Set the used bit for this page to true.
-			used[block][page] = true;
-			used_page_count++;
+			// Set the used bit for this page to true and update the address map.
+			map_page(vAddr, block, page);
 
 			// Pop the transaction from the transaction queue.
-			popFront(write_type);
+			pop_transaction();
 
-			// The FTL is no longer busy.
-			busy = 0;
+			// The engine is no longer busy.
+			current->busy = false;
 
 			// Update the write counter.
 			write_counter++;
@@ -599,65 +728,211 @@ void Ftl::handle_write(bool gc)
 				else
 					log->write_unmapped();
 			}
-
-			// Update the address map.
-			addressMap[vAddr] = pAddr;
 			//cout << "Added " << hex << vAddr << " -> " << pAddr << dec << " to addressMap on cycle " << 100 << " " << currentClockCycle << "\n";
 		}
 	}
 }
 
+// Let go of the page a virtual address used to be in, returns true if the address was mapped.
+bool Ftl::unmap_page(uint64_t vAddr)
+{
+	uint64_t oldAddr = addressMap.lookup(vAddr);
+	if (oldAddr == NO_MAPPING)
+	{
+		return false;
+	}
 
-void Ftl::attemptWrite(uint64_t start, uint64_t *vAddr, uint64_t *pAddr, bool *done){
-	uint64_t block, page;
-
-	for (block = start ; block < TOTAL_SIZE / BLOCK_SIZE && !*done; block++){
-		for (page = 0 ; page < PAGES_PER_BLOCK  && !*done ; page++){
-			if (!used[block][page]){
-				*pAddr = (block * BLOCK_SIZE + page * NV_PAGE_SIZE);
-				*done = true;
-			}
-		}
+	// only let go of the old page the first time we try this write, if the controller queues
+	// were full last time the page has already been handled and may even belong to someone else now
+	if (reverseMap[oldAddr / NV_PAGE_SIZE] == vAddr)
+	{
+		write_used_handler(vAddr);
+		reverseMap[oldAddr / NV_PAGE_SIZE] = NO_MAPPING;
 	}
+
+	return true;
+}
+
+void Ftl::map_page(uint64_t vAddr, uint64_t block, uint64_t page)
+{
+	uint64_t pAddr = (block * BLOCK_SIZE + page * NV_PAGE_SIZE);
+
+	use_page(block, page);
+	used_page_count++;
+
+	addressMap.map(vAddr, pAddr);
+	reverseMap[pAddr / NV_PAGE_SIZE] = vAddr;
 }
 
 uint64_t Ftl::get_ptr(void) {
 	// Return a pointer to the current plane.
 	return NV_PAGE_SIZE * PAGES_PER_BLOCK * BLOCKS_PER_PLANE * 
-		(plane + PLANES_PER_DIE * (die + NUM_PACKAGES * channel));
+		(plane + PLANES_PER_DIE * (die + DIES_PER_PACKAGE * channel));
 }
 
-void Ftl::popFront(ChannelPacketType type)
-{
-    // if we've put stuff into different queues we must now figure out which queue to pop from
-    if(SCHEDULE)
-    {
-	if(type == READ || type == ERASE)
-	{
-	    readQueue.pop_front();
-	    if(LOGGING && QUEUE_EVENT_LOG)
-	    {
-		log->log_ftl_queue_event(false, &readQueue);
-	    }
-	    
+void Ftl::inc_ptr(void) {
+	// Move the write pointer to the next plane, striping across the channels, then the dies, then the planes.
+	channel = (channel + 1) % NUM_PACKAGES;
+	if (channel == 0){
+		die = (die + 1) % DIES_PER_PACKAGE;
+		if (die == 0)
+			plane = (plane + 1) % PLANES_PER_DIE;
 	}
-	else if(type == WRITE)
-	{
-	    writeQueue.pop_front();
-	    if(LOGGING && QUEUE_EVENT_LOG)
-	    {
-		log->log_ftl_queue_event(true, &writeQueue);
-	    }
+}
+
+// Each plane keeps a list of the blocks that have free pages and an active block that it is filling up.
+// Writes go to the active block of the plane under the write pointer, so allocation and release don't
+// depend on the size of the device.
+void Ftl::build_free_lists(void) {
+	uint64_t i, block;
+
+	total_free_pages = 0;
+	for (i = 0; i < free_blocks.size(); i++){
+		free_blocks[i].clear();
+		active_block[i] = NO_ACTIVE_BLOCK;
+		next_page[i] = 0;
 	}
-    }
-    // if we're just putting everything into the read queue, just pop from there
-    else
-    {
-	readQueue.pop_front();
-	if(LOGGING && QUEUE_EVENT_LOG)
-	{
-	    log->log_ftl_queue_event(false, &readQueue);
+
+	for (block = 0; block < used.blocks(); block++){
+		total_free_pages += PAGES_PER_BLOCK - used.count(block);
+
+		block_queued[block] = (used.count(block) < PAGES_PER_BLOCK && !block_retired[block]);
+		if (block_queued[block])
+			free_blocks[block / BLOCKS_PER_PLANE].push_back(block);
+	}
+}
+
+bool Ftl::find_free_page(uint64_t *block, uint64_t *page) {
+	uint64_t i, c = channel, d = die, p = plane;
+
+	if (total_free_pages == 0)
+		return false;
+
+	// Try the plane under the write pointer first. If it's full, fall through to the planes that
+	// come after it in the striping order.
+	for (i = 0; i < free_blocks.size(); i++){
+		if (find_free_page_in_plane(p + PLANES_PER_DIE * (d + DIES_PER_PACKAGE * c), block, page))
+			return true;
+
+		c = (c + 1) % NUM_PACKAGES;
+		if (c == 0){
+			d = (d + 1) % DIES_PER_PACKAGE;
+			if (d == 0)
+				p = (p + 1) % PLANES_PER_DIE;
+		}
+	}
+
+	return false;
+}
+
+bool Ftl::find_free_page_in_plane(uint64_t plane_index, uint64_t *block, uint64_t *page) {
+	uint64_t b;
+
+	while (true){
+		// start writing into the next block with free pages
+		if (active_block[plane_index] == NO_ACTIVE_BLOCK){
+			if (free_blocks[plane_index].empty())
+				return false;
+
+			active_block[plane_index] = free_blocks[plane_index].front();
+			free_blocks[plane_index].pop_front();
+			block_queued[active_block[plane_index]] = false;
+			next_page[plane_index] = 0;
+
+			// blocks that were picked for erasing while they sat in the list are just dropped
+			if (block_retired[active_block[plane_index]]){
+				active_block[plane_index] = NO_ACTIVE_BLOCK;
+				continue;
+			}
+		}
+
+		// skip over anything in the active block that is still in use
+		b = active_block[plane_index];
+		next_page[plane_index] = used.first_clear(b, next_page[plane_index]);
+
+		if (next_page[plane_index] < PAGES_PER_BLOCK){
+			*block = b;
+			*page = next_page[plane_index];
+			return true;
+		}
+
+		// the active block is full
+		active_block[plane_index] = NO_ACTIVE_BLOCK;
+		if (used.count(b) < PAGES_PER_BLOCK && !block_retired[b]){
+			free_blocks[plane_index].push_back(b);
+			block_queued[b] = true;
+		}
 	}
+}
+
+void Ftl::use_page(uint64_t block, uint64_t page) {
+	used.set(block, page);
+	total_free_pages--;
+}
+
+void Ftl::free_page(uint64_t block, uint64_t page) {
+	uint64_t plane_index = block / BLOCKS_PER_PLANE;
+
+	if (!used.get(block, page))
+		return;
+
+	used.clear(block, page);
+	total_free_pages++;
+
+	// if this is the block we're writing into just back the cursor up, otherwise make sure
+	// the block is on the free list
+	if (block == active_block[plane_index]){
+		if (page < next_page[plane_index])
+			next_page[plane_index] = page;
+	}
+	else if (!block_queued[block] && !block_retired[block]){
+		free_blocks[plane_index].push_back(block);
+		block_queued[block] = true;
+	}
+}
+
+// Release every page in a block at once, this is what happens when a block is erased.
+void Ftl::free_block(uint64_t block) {
+	uint64_t plane_index = block / BLOCKS_PER_PLANE;
+
+	total_free_pages += used.count(block);
+	used.clear_block(block);
+
+	if (block == active_block[plane_index])
+		next_page[plane_index] = 0;
+	else if (!block_queued[block] && !block_retired[block]){
+		free_blocks[plane_index].push_back(block);
+		block_queued[block] = true;
+	}
+}
+
+// Stop writing into a block that is going to be erased. It stays out of the free lists until it is reclaimed.
+void Ftl::retire_block(uint64_t block) {
+	uint64_t plane_index = block / BLOCKS_PER_PLANE;
+
+	block_retired[block] = true;
+	if (block == active_block[plane_index])
+		active_block[plane_index] = NO_ACTIVE_BLOCK;
+}
+
+void Ftl::reclaim_block(uint64_t block) {
+	block_retired[block] = false;
+	if (used.count(block) < PAGES_PER_BLOCK && !block_queued[block] && block != active_block[block / BLOCKS_PER_PLANE]){
+		free_blocks[block / BLOCKS_PER_PLANE].push_back(block);
+		block_queued[block] = true;
+	}
+}
+
+// take the transaction the current engine is done with out of its queue
+void Ftl::pop_transaction(void)
+{
+    bool write = (current->queue == &writeQueue);
+
+    current->queue->erase(current->position);
+    sendQueueLength();
+    if(LOGGING && QUEUE_EVENT_LOG)
+    {
+	log->log_ftl_queue_event(write, current->queue);
     }
 }
 
@@ -695,134 +970,198 @@ void Ftl::sendQueueLength(void)
 
 void Ftl::saveNVState(void)
 {
-	if(ENABLE_NV_SAVE && !saved)
+	if(parent->nv_save && !saved)
 	{
-		ofstream save_file;
-		save_file.open(NV_SAVE_FILE, ios_base::out | ios_base::trunc);
-		if(!save_file)
-		{
-			cout << "ERROR: Could not open NVDIMM state save file: " << NV_SAVE_FILE << "\n";
-			abort();
-		}
-
 		cout << "NVDIMM is saving the used table and address map \n";
-		cout << "save file is " << NV_SAVE_FILE << "\n";
+		cout << "save file is " << parent->nv_save_file << "\n";
+
+		Checkpoint::save(parent->nv_save_file, addressMap, used, NULL);
+		saved = true;
+	}
+}
 
-		// save the address map
-		save_file << "AddressMap \n";
-		std::unordered_map<uint64_t, uint64_t>::iterator it;
-		for (it = addressMap.begin(); it != addressMap.end(); it++)
+// Restores either a binary checkpoint or a state file in the old text format.
+void Ftl::loadNVState(void)
+{
+	if(parent->nv_restore && !loaded)
+	{
+		cout << "NVDIMM is restoring the system from file " << parent->nv_restore_file <<"\n";
+
+		if(Checkpoint::isCheckpoint(parent->nv_restore_file))
 		{
-			save_file << (*it).first << " " << (*it).second << " \n";
+			load_checkpoint();
 		}
+		else
+		{
+			load_text_state();
+		}
+		loaded = true;
 
-		// save the used table
-		save_file << "Used \n";
-		for(uint i = 0; i < used.size(); i++)
+		used_page_count = 0;
+		for(uint64_t block = 0; block < used.blocks(); block++)
 		{
-			save_file << "\n";
-			for(uint j = 0; j < used[i].size()-1; j++)
-			{
-				save_file << used[i][j] << " ";
-			}
-			save_file << used[i][used[i].size()-1];
+			used_page_count += used.count(block);
 		}
 
-		save_file.close();
-		saved = true;
+		build_free_lists();
 	}
 }
 
-void Ftl::loadNVState(void)
+// The tables are copied straight out of the mapped checkpoint and each block that has anything
+// in it is written to its plane in one go.
+void Ftl::load_checkpoint(void)
 {
-	if(ENABLE_NV_RESTORE && !loaded)
+	Checkpoint checkpoint;
+	uint64_t block, plane_block, words = used.words();
+
+	checkpoint.open(parent->nv_restore_file, addressMap, used);
+
+	addressMap.load(checkpoint.mapEntries(), checkpoint.unalignedEntries(), checkpoint.unalignedCount());
+	used.load(checkpoint.usedWords());
+	load_dirty(checkpoint);
+
+	std::fill(reverseMap.begin(), reverseMap.end(), NO_MAPPING);
+	addressMap.forEach([this](uint64_t vAddr, uint64_t pAddr)
+	{
+		reverseMap[pAddr / NV_PAGE_SIZE] = vAddr;
+	});
+
+	for(block = 0; block < used.blocks(); block++)
 	{
-		ifstream restore_file;
-		restore_file.open(NV_RESTORE_FILE);
-		if(!restore_file)
+		if(used.count(block) == 0)
 		{
-			cout << "ERROR: Could not open NVDIMM restore file: " << NV_RESTORE_FILE << "\n";
-			abort();
+			continue;
 		}
 
-		cout << "NVDIMM is restoring the system from file " << NV_RESTORE_FILE <<"\n";
+		// same breakdown as translate
+		plane_block = block / BLOCKS_PER_PLANE;
+		controller->populatePackage(plane_block / (PLANES_PER_DIE * DIES_PER_PACKAGE),
+					    (plane_block / PLANES_PER_DIE) % DIES_PER_PACKAGE,
+					    plane_block % PLANES_PER_DIE,
+					    block % BLOCKS_PER_PLANE, used.data() + block * words, words);
+	}
+}
 
-		// restore the data
-		bool doing_used = 0;
-	        bool doing_addresses = 0;
-		uint64_t row = 0;
-		uint64_t column = 0;
-		bool first = 0;
-		uint64_t key = 0;
-		uint64_t pAddr, vAddr = 0;
+// an ftl without garbage collection frees overwritten pages right away so there's no dirty table to restore,
+// any pages that were dirty in a checkpoint from a gc ftl are just freed
+void Ftl::load_dirty(Checkpoint &checkpoint)
+{
+	uint64_t block, w, bits;
 
-		std::unordered_map<uint64_t,uint64_t> tempMap;
+	if(!checkpoint.hasDirty())
+	{
+		return;
+	}
 
-		std::string temp;
+	for(block = 0; block < used.blocks(); block++)
+	{
+		for(w = 0; w < used.words(); w++)
+		{
+			bits = checkpoint.dirtyWords()[block * used.words() + w] & used.word(block, w);
+			while(bits != 0)
+			{
+				used.clear(block, (w << 6) + __builtin_ctzll(bits));
+				bits &= bits - 1;
+			}
+		}
+	}
+}
+
+// importer for state files saved in the old text format
+void Ftl::load_text_state(void)
+{
+	ifstream restore_file;
+	restore_file.open(parent->nv_restore_file);
+	if(!restore_file)
+	{
+		cout << "ERROR: Could not open NVDIMM restore file: " << parent->nv_restore_file << "\n";
+		abort();
+	}
+
+	// restore the data
+	bool doing_used = 0;
+        bool doing_addresses = 0;
+	uint64_t row = 0;
+	uint64_t column = 0;
+	bool first = 0;
+	uint64_t key = 0;
+	uint64_t pAddr, vAddr = 0;
+
+	std::string temp;
+
+	while(!restore_file.eof())
+	{ 
+		restore_file >> temp;
+		// don't process the last token a second time when we hit the end of the file
+		if(restore_file.fail())
+		{
+			break;
+		}
+		
+		// these comparisons make this parser work but they are dependent on the ordering of the data in the state file
+		// if the state file changes these comparisons may also need to be changed
+		if(temp.compare("Used") == 0)
+		{
+			doing_used = 1;
+			doing_addresses = 0;
+		}
+		else if(temp.compare("AddressMap") == 0)
+		{
+		        doing_used = 0;
+			doing_addresses = 1;
+		}
+		// restore used data
+		// have the row check cause eof sux
+		else if(doing_used == 1)
+		{
+			if(convert_uint64_t(temp))
+				used.set(row, column);
+			else
+				used.clear(row, column);
 
-		while(!restore_file.eof())
-		{ 
-			restore_file >> temp;
-			
-			// these comparisons make this parser work but they are dependent on the ordering of the data in the state file
-			// if the state file changes these comparisons may also need to be changed
-			if(temp.compare("Used") == 0)
+			// this page was used need to issue fake write
+			if(temp.compare("1") == 0)
 			{
-				doing_used = 1;
-				doing_addresses = 0;
+				pAddr = (row * BLOCK_SIZE + column * NV_PAGE_SIZE);
+				vAddr = reverseMap[pAddr / NV_PAGE_SIZE];
+				ChannelPacket *tempPacket = Ftl::translate(WRITE, 0, vAddr, pAddr);
+				controller->writeToPackage(tempPacket);
 			}
-			else if(temp.compare("AddressMap") == 0)
+
+			column++;
+			if(column >= PAGES_PER_BLOCK)
 			{
-			        doing_used = 0;
-				doing_addresses = 1;
+				row++;
+				column = 0;
 			}
-			// restore used data
-			// have the row check cause eof sux
-			else if(doing_used == 1)
+		}
+		// restore address map data
+		else if(doing_addresses == 1)
+		{
+			if(first == 0)
 			{
-				used[row][column] = convert_uint64_t(temp);
-
-				// this page was used need to issue fake write
-				if(temp.compare("1") == 0)
-				{
-					pAddr = (row * BLOCK_SIZE + column * NV_PAGE_SIZE);
-					vAddr = tempMap[pAddr];
-					ChannelPacket *tempPacket = Ftl::translate(WRITE, vAddr, pAddr);
-					controller->writeToPackage(tempPacket);
-				}
-
-				column++;
-				if(column >= PAGES_PER_BLOCK)
-				{
-					row++;
-					column = 0;
-				}
+				first = 1;
+				key = convert_uint64_t(temp);
 			}
-			// restore address map data
-			else if(doing_addresses == 1)
+			else
 			{
-				if(first == 0)
-				{
-					first = 1;
-					key = convert_uint64_t(temp);
-				}
-				else
-				{
-					addressMap[key] = convert_uint64_t(temp);
-					tempMap[convert_uint64_t(temp)] = key;
-					first = 0;
-				}
+				addressMap.map(key, convert_uint64_t(temp));
+				reverseMap[convert_uint64_t(temp) / NV_PAGE_SIZE] = key;
+				first = 0;
 			}
 		}
-
-		restore_file.close();
-		loaded = true;
 	}
+
+	restore_file.close();
 }
 
 void Ftl::queuesNotFull(void)
 {
-    queues_full = false;
+    uint i;
+    for (i = 0; i < engines.size(); i++)
+    {
+	engines[i].queues_full = false;
+    }
 }
 
 void Ftl::GCReadDone(uint64_t vAddr)
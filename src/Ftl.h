@@ -39,39 +39,72 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <deque>
 #include "SimObj.h"
 #include "FlashConfiguration.h"
 #include "ChannelPacket.h"
 #include "FlashTransaction.h"
 #include "Controller.h"
 #include "Logger.h"
+#include "MappingTable.h"
+#include "PageBitmap.h"
+#include "Checkpoint.h"
 #include "Util.h"
 
+// marks a plane that isn't currently writing into any block
+#define NO_ACTIVE_BLOCK ((uint64_t) -1)
+
 namespace NVDSim{
         class NVDIMM;
 	class Ftl : public SimObj{
 		public:
 	                Ftl(Controller *c, Logger *l, NVDIMM *p);
 
-			ChannelPacket *translate(ChannelPacketType type, uint64_t vAddr, uint64_t pAddr);
+			ChannelPacket *translate(ChannelPacketType type, uint64_t id, uint64_t vAddr, uint64_t pAddr);
 			virtual bool addTransaction(FlashTransaction &t);
-			void addFfTransaction(FlashTransaction &t);
+			virtual void addFfTransaction(FlashTransaction &t);
+			bool ff_write(uint64_t vAddr);
 			virtual void update(void);
+			virtual uint64_t nextEvent(void);
+			void skipCycles(uint64_t cycles);
 			void handle_read(bool gc);
 			virtual void write_used_handler(uint64_t vAddr);
 			void handle_write(bool gc);
-			void attemptWrite(uint64_t start, uint64_t *vAddr, uint64_t *pAddr, bool *done);
+			bool unmap_page(uint64_t vAddr);
+			void map_page(uint64_t vAddr, uint64_t block, uint64_t page);
 			uint64_t get_ptr(void); 
 			void inc_ptr(void); 
 
-			virtual void popFront(ChannelPacketType type);
-
-			void sendQueueLength(void);
+			// page allocation
+			void build_free_lists(void);
+			bool find_free_page(uint64_t *block, uint64_t *page);
+			bool find_free_page_in_plane(uint64_t plane_index, uint64_t *block, uint64_t *page);
+			void use_page(uint64_t block, uint64_t page);
+			void free_page(uint64_t block, uint64_t page);
+			void free_block(uint64_t block);
+			void retire_block(uint64_t block);
+			void reclaim_block(uint64_t block);
+
+			// lookup engines
+			bool start_lookup(std::list<FlashTransaction> &queue);
+			bool lookup_conflict(uint64_t vAddr);
+			bool lookup_ready(std::list<FlashTransaction> &queue);
+			bool in_lookup(std::list<FlashTransaction>::iterator it);
+			bool idle_engine(void);
+			uint64_t queued_writes(void);
+			uint64_t lookup_event(void);
+			virtual void pop_transaction(void);
+
+			// tells the logger how long the queues are, this is called whenever they change
+			virtual void sendQueueLength(void);
 			
 			void powerCallback(void);
 
 			virtual void saveNVState(void);
 			virtual void loadNVState(void);
+			void load_checkpoint(void);
+			virtual void load_dirty(Checkpoint &checkpoint);
+			virtual void load_text_state(void);
 
 			void queuesNotFull(void);
 			void flushWriteQueues(void);
@@ -87,26 +120,57 @@ namespace NVDSim{
 		protected:
 			bool gc_flag;
 			uint offset,  pageBitWidth, blockBitWidth, planeBitWidth, dieBitWidth, packageBitWidth;
-			uint channel, die, plane, lookupCounter;
+			uint channel, die, plane;
 			uint64_t max_queue_length;
-			FlashTransaction currentTransaction;
-			uint busy;
 
-			uint64_t deadlock_counter;
+			// Each engine translates one transaction at a time. A transaction stays in its queue while
+			// it is being looked up, so it still counts against the queue length until the controller
+			// takes it.
+			class LookupEngine
+			{
+			public:
+			    std::list<FlashTransaction> *queue; //the queue the transaction is in
+			    std::list<FlashTransaction>::iterator position;
+			    uint lookupCounter;
+			    uint queue_access_counter; //cycles left reading data out of the write queue
+			    void *queue_data; //the data a read found in the write queue
+			    bool busy;
+			    bool queues_full; //the controller had no room for this transaction
+			    uint64_t deadlock_counter; //cycles this engine has gone without finding a free page
+
+			    LookupEngine()
+			    {
+				queue = NULL;
+				lookupCounter = 0;
+				queue_access_counter = 0;
+				queue_data = NULL;
+				busy = false;
+				queues_full = false;
+				deadlock_counter = 0;
+			    }
+			};
+			std::vector<LookupEngine> engines;
+			LookupEngine *current; //the engine update is working on
+
 			uint64_t deadlock_time;
 			uint64_t write_counter;
 			uint64_t used_page_count;
 
 			bool saved;
 			bool loaded;
-			bool queues_full;
 			bool flushing_write;
 
-			uint queue_access_counter;
-			std::list<FlashTransaction>::iterator reading_write;
-
-			std::unordered_map<uint64_t,uint64_t> addressMap;
-			std::vector<vector<bool>> used;
+			MappingTable addressMap;
+			std::vector<uint64_t> reverseMap; //indexed by physical page, holds the virtual address stored there or NO_MAPPING
+			PageBitmap used;
+
+			// page allocator state
+			std::vector<std::deque<uint64_t> > free_blocks; //per plane, blocks with free pages waiting to be written
+			std::vector<uint64_t> active_block; //per plane, the block currently being written
+			std::vector<uint64_t> next_page; //per plane, the first page in the active block that might be free
+			std::vector<bool> block_queued; //per block, is this block in its plane's free list
+			std::vector<bool> block_retired; //per block, is this block waiting to be erased
+			uint64_t total_free_pages;
 			std::list<FlashTransaction> readQueue;
 			std::list<FlashTransaction> writeQueue;
 	};
@@ -50,10 +50,18 @@ GCFtl::GCFtl(Controller *c, Logger *l, NVDIMM *p)
 	used_page_count = 0;
 	gc_status = 0;
 	panic_mode = 0;
+	panic_erases = 0;
 
 	dirty_page_count = 0;
 
-	dirty = vector<vector<bool>>(numBlocks, vector<bool>(PAGES_PER_BLOCK, false));
+	dirty = PageBitmap(numBlocks, PAGES_PER_BLOCK);
+
+	uint64_t numPlanes = NUM_PACKAGES * DIES_PER_PACKAGE * PLANES_PER_DIE;
+	dirty_pages = vector<uint64_t>(numBlocks, 0);
+	dirty_buckets = vector<vector<list<uint64_t> > >(numPlanes, vector<list<uint64_t> >(PAGES_PER_BLOCK + 1, list<uint64_t>()));
+	bucket_position = vector<list<uint64_t>::iterator>(numBlocks);
+	max_dirty = vector<uint64_t>(numPlanes, 0);
+	build_dirty_buckets();
 	
 	gcQueue = list<FlashTransaction>();
 
@@ -79,10 +87,11 @@ bool GCFtl::addTransaction(FlashTransaction &t){
 		    if (!panic_mode)
 		    {
 			readQueue.push_back(t);
+			sendQueueLength();
 			if(LOGGING == true)
 			{
 			    // Start the logging for this access.
-			    log->access_start(t.address);
+			    log->access_start(t.id);
 			    if(QUEUE_EVENT_LOG)
 			    {
 			       log->log_ftl_queue_event(false, &readQueue);
@@ -106,23 +115,22 @@ bool GCFtl::addTransaction(FlashTransaction &t){
 		    {
 			// see if this write replaces another already in the write queue
 			// if it does remove that other write from the queue
+			// a write that is being looked up can't be replaced, both of them go to the device
 			list<FlashTransaction>::iterator it;
 			for (it = writeQueue.begin(); it != writeQueue.end(); it++)
 			{
-			    if((*it).address == t.address)
+			    if((*it).address == t.address && !in_lookup(it))
 			    {
 				if(LOGGING)
 				{
 				    // access_process for that write is called here since its over now.
-				    log->access_process(t.address, t.address, 0, WRITE);
+				    log->access_process((*it).id, t.address, 0, WRITE);
 
 				    // stop_process for that write is called here since its over now.
-				    log->access_stop(t.address, t.address);
+				    log->access_stop((*it).id);
 				}
 				// issue a callback for this write
-				if (parent->WriteDataDone != NULL){
-				    (*parent->WriteDataDone)(parent->systemID, (*it).address, currentClockCycle, true);
-				}
+				parent->writeDone((*it).id, (*it).address, currentClockCycle);
 				writeQueue.erase(it);
 				break;
 			    }
@@ -131,7 +139,7 @@ bool GCFtl::addTransaction(FlashTransaction &t){
 			if(LOGGING == true)
 			{
 			    // Start the logging for this access.
-			    log->access_start(t.address);
+			    log->access_start(t.id);
 			    if(QUEUE_EVENT_LOG)
 			    {
 				log->log_ftl_queue_event(true, &writeQueue);
@@ -155,11 +163,12 @@ bool GCFtl::addTransaction(FlashTransaction &t){
 	    else
 	    {
 		readQueue.push_back(t);
+		sendQueueLength();
 		
 		if(LOGGING == true)
 		{
 		    // Start the logging for this access.
-		    log->access_start(t.address);
+		    log->access_start(t.id);
 		    if(QUEUE_EVENT_LOG)
 		    {
 			log->log_ftl_queue_event(false, &readQueue);
@@ -174,24 +183,59 @@ bool GCFtl::addTransaction(FlashTransaction &t){
 }
 
 void GCFtl::addGcTransaction(FlashTransaction &t){ 
+    // the gc's own transactions are tracked like any other request
+    t.id = parent->newRequestId();
+
     // we use a special GC queue whether we're scheduling or not so always just do it like this
     gcQueue.push_back(t);
-    queues_full = false;
+    sendQueueLength();
+    queuesNotFull();
     
     if(LOGGING == true)
     {
 	// Start the logging for this access.
-	log->access_start(t.address);
+	log->access_start(t.id);
     }
 }
 
+// Fast forward writes go through the same gc policy as timed writes, but the gc is done immediately
+// whenever a write can't find a free page or the idle gc threshold has been passed.
+void GCFtl::addFfTransaction(FlashTransaction &t){
+	if (t.address >= (VIRTUAL_TOTAL_SIZE*1024))
+	{
+		ERROR("Tried to fast forward a transaction with a virtual address that was out of bounds");
+		exit(5001);
+	}
+
+	if (t.transactionType == DATA_WRITE)
+	{
+		while (!ff_write(t.address))
+		{
+			if (dirty_page_count == 0)
+			{
+				ERROR("FLASH DIMM IS FULL OF USED PAGES AND NONE OF THEM ARE DIRTY - there is nothing the gc can do.");
+				exit(7001);
+			}
+			ff_gc();
+		}
+
+		if (checkGC() && dirty_page_count != 0)
+			ff_gc();
+	}
+	else if (t.transactionType != DATA_READ)
+	{
+		ERROR("Only reads and writes can be fast forwarded");
+		exit(5002);
+	}
+}
+
 void GCFtl::update(void){
 	uint i;
 
 	if (gc_status){
 		if (!panic_mode && parent->numErases == start_erase + 1)
 			gc_status = 0;
-		if (panic_mode && parent->numErases == start_erase + PLANES_PER_DIE * DIES_PER_PACKAGE * NUM_PACKAGES){
+		if (panic_mode && parent->numErases == start_erase + panic_erases){
 			panic_mode = 0;
 			gc_status = 0;
 		}
@@ -203,12 +247,19 @@ void GCFtl::update(void){
 		start_erase = parent->numErases;
 		gc_status = 1;
 		panic_mode = 1;
-		busy = 0;
+		// drop whatever the engines were doing, it stays in its queue for later
+		for (i = 0; i < engines.size(); i++)
+		{
+			engines[i].busy = false;
+			engines[i].queue_access_counter = 0;
+		}
 		//cout << (float)(FORCE_GC_THRESHOLD * (VIRTUAL_TOTAL_SIZE / NV_PAGE_SIZE)) << "\n";
 		//cout << (float)used_page_count << "\n";
+		panic_erases = 0;
 		for (i = 0 ; i < PLANES_PER_DIE * DIES_PER_PACKAGE * NUM_PACKAGES; i++)
 		{
-			runGC(i);
+			if (runGC(i))
+				panic_erases++;
 		}
 	    }
 	    else if((float)used_page_count >= (float)(VIRTUAL_TOTAL_SIZE / NV_PAGE_SIZE))
@@ -218,13 +269,16 @@ void GCFtl::update(void){
 	    }
 	}
 
-	if (busy) {
-	    if (lookupCounter <= 0 && !queues_full){
-			uint64_t vAddr = currentTransaction.address;
+	for (i = 0; i < engines.size(); i++) {
+	    current = &engines[i];
+
+	    if (current->busy) {
+		if (current->lookupCounter <= 0 && !current->queues_full){
+			uint64_t vAddr = (*current->position).address;
 			bool result = false;
 			ChannelPacket *commandPacket;
 			
-			switch (currentTransaction.transactionType){
+			switch ((*current->position).transactionType){
 				case DATA_READ:
 					handle_read(false);
 					break;
@@ -242,34 +296,18 @@ void GCFtl::update(void){
 					break;
 
 				case BLOCK_ERASE:
-					commandPacket = Ftl::translate(ERASE, vAddr, vAddr);//note: vAddr is actually the pAddr in this case with the way garbage collection is written
+					commandPacket = Ftl::translate(ERASE, (*current->position).id, vAddr, vAddr);//note: vAddr is actually the pAddr in this case with the way garbage collection is written
 					result = controller->addPacket(commandPacket);
 					if(result == true)
 					{
-					    for (i = 0 ; i < PAGES_PER_BLOCK ; i++){
-						if (dirty[vAddr / BLOCK_SIZE][i]){
-							dirty[vAddr / BLOCK_SIZE][i] = false;
-							dirty_page_count--;
-						}
-						if (used[vAddr / BLOCK_SIZE][i]){
-							used[vAddr / BLOCK_SIZE][i] = false;
-							used_page_count--;
-						}
-					    }
-					    if(gc_status)
-					    {
-						gcQueue.pop_front();
-					    }
-					    else
-					    {
-						readQueue.pop_front();
-					    }
-					    busy = 0;
+					    clean_block(vAddr / BLOCK_SIZE);
+					    pop_transaction();
+					    current->busy = false;
 					}
 					else
 					{
-					    delete commandPacket;
-					    queues_full = true;
+					    parent->releasePacket(commandPacket);
+					    current->queues_full = true;
 					}
 					break;		
 
@@ -279,53 +317,40 @@ void GCFtl::update(void){
 					break;
 			}
 		} 
-		else if(lookupCounter > 0)
+		else if(current->lookupCounter > 0)
 		{
-			lookupCounter--;
+			current->lookupCounter--;
 		}
-	} 
-	// Not currently busy.
-	else {
-	    // if we're doing gc stuff then everything should be coming from the gc queue
-	    if(gc_status)
-	    {
-		if (!gcQueue.empty()) {
-		    busy = 1;
-		    currentTransaction = gcQueue.front();
-		    lookupCounter = LOOKUP_TIME;
-		}
-	    }
-	    // if we're not in gc mode and...
-	    // we're favoring reads over writes so we need to check the write queues to make sure they
-	    // aren't filling up. if they are we issue a write, otherwise we just keeo on issuing reads
-	    else if(SCHEDULE)
-	    {
-		// do we need to issue a write?
-		if((WRITE_ON_QUEUE_SIZE == true && writeQueue.size() >= WRITE_QUEUE_LIMIT) ||
-		    (WRITE_ON_QUEUE_SIZE == false && writeQueue.size() >= FTL_WRITE_QUEUE_LENGTH-1))
+	    } 
+	    // Not currently busy.
+	    else {
+		// if we're doing gc stuff then everything should be coming from the gc queue
+		if(gc_status)
 		{
-		    busy = 1;
-		    currentTransaction = writeQueue.front();
-		    lookupCounter = LOOKUP_TIME;
+		    start_lookup(gcQueue);
 		}
-		// no? then issue a read
-		else
+		// if we're not in gc mode and...
+		// we're favoring reads over writes so we need to check the write queues to make sure they
+		// aren't filling up. if they are we issue a write, otherwise we just keeo on issuing reads
+		else if(SCHEDULE)
 		{
-		    if (!readQueue.empty()) {
-			busy = 1;
-			currentTransaction = readQueue.front();
-			lookupCounter = LOOKUP_TIME;
+		    // do we need to issue a write?
+		    if(((WRITE_ON_QUEUE_SIZE == true && queued_writes() >= WRITE_QUEUE_LIMIT) ||
+			(WRITE_ON_QUEUE_SIZE == false && queued_writes() >= FTL_WRITE_QUEUE_LENGTH-1)) &&
+		       start_lookup(writeQueue))
+		    {
+		    }
+		    // no? then issue a read
+		    else if (start_lookup(readQueue))
+		    {
 		    }
 		    // no reads to issue? then issue a write if we have opted to issue writes during idle
-		    else if(IDLE_WRITE == true && !writeQueue.empty())
+		    else if(IDLE_WRITE == true && start_lookup(writeQueue))
 		    {
-			busy = 1;
-			currentTransaction = writeQueue.front();
-			lookupCounter = LOOKUP_TIME;
 		    }
 		    // still need something to do?
 		    // Check to see if GC needs to run.
-		    else {
+		    else if (readQueue.empty() && (IDLE_WRITE == false || writeQueue.empty())) {
 			if (checkGC() && !gc_status && dirty_page_count != 0)
 			{
 				// Run the GC.
@@ -335,15 +360,11 @@ void GCFtl::update(void){
 			}
 		    }
 		}
-	    }
-	     // we're not scheduling so everything is in the read queue
-	    // just issue from there
-	    else
-	    {
-		if (!readQueue.empty()) {
-		    busy = 1;
-		    currentTransaction = readQueue.front();
-		    lookupCounter = LOOKUP_TIME;
+		 // we're not scheduling so everything is in the read queue
+		// just issue from there
+		else
+		{
+		    start_lookup(readQueue);
 		}
 	    }
 	}
@@ -355,10 +376,53 @@ void GCFtl::update(void){
 
 }
 
+uint64_t GCFtl::nextEvent(void){
+	uint64_t next;
+
+	// an erase we were waiting on has finished
+	if (gc_status){
+		if ((!panic_mode && parent->numErases == start_erase + 1) ||
+		    (panic_mode && parent->numErases == start_erase + panic_erases))
+			return 0;
+	}
+
+	// we are about to panic
+	if (!gc_status && (float)used_page_count >= (float)(FORCE_GC_THRESHOLD * (VIRTUAL_TOTAL_SIZE / NV_PAGE_SIZE)) &&
+	    (dirty_page_count != 0 || (float)used_page_count >= (float)(VIRTUAL_TOTAL_SIZE / NV_PAGE_SIZE)))
+		return 0;
+
+	if (!gc_status && !SCHEDULE)
+		return Ftl::nextEvent();
+
+	next = lookup_event();
+	if (next == 0 || !idle_engine())
+		return next;
+
+	if (gc_status)
+	{
+		if (lookup_ready(gcQueue))
+			return 0;
+	}
+	else if ((((WRITE_ON_QUEUE_SIZE == true && queued_writes() >= WRITE_QUEUE_LIMIT) ||
+		   (WRITE_ON_QUEUE_SIZE == false && queued_writes() >= FTL_WRITE_QUEUE_LENGTH-1) ||
+		   IDLE_WRITE == true) && lookup_ready(writeQueue)) ||
+		 lookup_ready(readQueue) ||
+		 (checkGC() && dirty_page_count != 0))
+	{
+		return 0;
+	}
+
+	return next;
+}
+
 void GCFtl::write_used_handler(uint64_t vAddr)
 {
-	dirty[addressMap[vAddr] / BLOCK_SIZE][(addressMap[vAddr] / NV_PAGE_SIZE) % PAGES_PER_BLOCK] = true;
+	uint64_t pAddr = addressMap.lookup(vAddr);
+	uint64_t block = pAddr / BLOCK_SIZE;
+
+	dirty.set(block, (pAddr / NV_PAGE_SIZE) % PAGES_PER_BLOCK);
 	dirty_page_count ++;
+	set_dirty_pages(block, dirty.count(block));
 
 	//cout << "USING GCFTL's WRITE_USED_HANDLER!!!\n";
 	//cout << "Block " << addressMap[vAddr] / BLOCK_SIZE << " Page " << addressMap[vAddr] / NV_PAGE_SIZE << " is now dirty \n";
@@ -373,82 +437,108 @@ bool GCFtl::checkGC(void){
 
 
 void GCFtl::runGC() {
-  uint64_t block, page, count, dirty_block=0, dirty_count=0;
-	FlashTransaction trans;
-	PendingErase temp_erase;
-
-	// Get the dirtiest block (assumes the flash keeps track of this with an online algorithm).
-	for (block = erase_pointer; block < TOTAL_SIZE / BLOCK_SIZE; block++) {
-	  count = 0;
-	  for (page = 0; page < PAGES_PER_BLOCK; page++) {
-		if (dirty[block][page] == true) {
-			count++;
+	uint64_t block;
+
+	if (pick_victim(&block))
+		addGC(block);
+}
+
+// find the block the gc should clean next, returns false if there are no dirty pages anywhere
+bool GCFtl::pick_victim(uint64_t *block) {
+	uint64_t i, p, plane = 0, dirty_count = 0;
+	uint64_t numPlanes = NUM_PACKAGES * DIES_PER_PACKAGE * PLANES_PER_DIE;
+
+	// Get the dirtiest block, each plane already knows its dirtiest block so we only have to compare the planes.
+	// Start with the plane after the last one we cleaned so the gc isn't always erasing the same spot.
+	for (i = 0; i < numPlanes; i++) {
+		p = (erase_pointer + i) % numPlanes;
+		if (max_dirty[p] > dirty_count) {
+			dirty_count = max_dirty[p];
+			plane = p;
 		}
-	  }
-	  if (count > dirty_count) {
-	      	dirty_count = count;
-	       	dirty_block = block;
-	  }
 	}
-	erase_pointer = (dirty_block + 1) % (TOTAL_SIZE / BLOCK_SIZE);
 
-	addGC(dirty_block);
+	if (dirty_count == 0)
+		return false;
+	erase_pointer = (plane + 1) % numPlanes;
+
+	*block = dirty_buckets[plane][dirty_count].front();
+	return true;
 }
 
 // overloaded version of runGC that we use in panic mode to issue a different erase to each plane
 // if we are in panic mode then the system is dangerously full, we need to make as much clean space as possible
 // so we will erase a block on every independent plane at the same time
-void GCFtl::runGC(uint64_t plane) {
-  uint64_t block, page, count, dirty_block=0, dirty_count=0;
-	FlashTransaction trans;
-	PendingErase temp_erase;
-
-	// Get the dirtiest block (assumes the flash keeps track of this with an online algorithm).
-	for (block = (plane * BLOCKS_PER_PLANE); block < ((plane + 1) * BLOCKS_PER_PLANE); block++) {
-	  count = 0;
-	  for (page = 0; page < PAGES_PER_BLOCK; page++) {
-		if (dirty[block][page] == true) {
-			count++;
-		}
-	  }
-	  if (count > dirty_count) {
-	      	dirty_count = count;
-	       	dirty_block = block;
-	  }
+// returns false if this plane has nothing to clean
+bool GCFtl::runGC(uint64_t plane) {
+	if (max_dirty[plane] == 0)
+		return false;
+
+	addGC(dirty_buckets[plane][max_dirty[plane]].front());
+	return true;
+}
+
+// move a block to the bucket for its new dirty page count
+void GCFtl::set_dirty_pages(uint64_t block, uint64_t count) {
+	uint64_t plane = block / BLOCKS_PER_PLANE;
+
+	if (dirty_pages[block] > 0)
+		dirty_buckets[plane][dirty_pages[block]].erase(bucket_position[block]);
+
+	dirty_pages[block] = count;
+	if (count > 0)
+		bucket_position[block] = dirty_buckets[plane][count].insert(dirty_buckets[plane][count].end(), block);
+
+	if (count > max_dirty[plane])
+		max_dirty[plane] = count;
+	while (max_dirty[plane] > 0 && dirty_buckets[plane][max_dirty[plane]].empty())
+		max_dirty[plane]--;
+}
+
+void GCFtl::build_dirty_buckets(void) {
+	uint64_t i, j, block;
+
+	for (i = 0; i < dirty_buckets.size(); i++) {
+		for (j = 0; j < dirty_buckets[i].size(); j++)
+			dirty_buckets[i][j].clear();
+		max_dirty[i] = 0;
 	}
 
-	addGC(dirty_block);
+	dirty_page_count = 0;
+	for (block = 0; block < dirty.blocks(); block++) {
+		dirty_page_count += dirty.count(block);
+
+		dirty_pages[block] = 0;
+		set_dirty_pages(block, dirty.count(block));
+	}
 }
 
 // the guts of the runGC function separated out to prevent duplicated code
 // this adds the read GC transactions if there are any and creates a pending erase entry
 void GCFtl::addGC(uint64_t dirty_block)
 {
-     uint64_t page, pAddr, vAddr, tmpAddr;
+     uint64_t w, valid, page, pAddr, vAddr;
      FlashTransaction trans;
      PendingErase temp_erase;
 
      // set the block we're going to erase with this gc operation
+     // and stop the allocator from putting any new data in it
      temp_erase.erase_block = dirty_block;
+     retire_block(dirty_block);
+
+     // All used pages in the dirty block that aren't dirty, they must be moved elsewhere.
+     for (w = 0; w < used.words(); w++) {
+	 valid = used.word(dirty_block, w) & ~dirty.word(dirty_block, w);
+	 while (valid != 0) {
+	     page = (w << 6) + __builtin_ctzll(valid);
+	     valid &= valid - 1;
 
-     // All used pages in the dirty block, they must be moved elsewhere.
-     for (page = 0; page < PAGES_PER_BLOCK; page++) {
-	 if (used[dirty_block][page] == true && dirty[dirty_block][page] == false) {
 	     // Compute the physical address to move.
 	     pAddr = (dirty_block * BLOCK_SIZE + page * NV_PAGE_SIZE);
 
-	     // Do a reverse lookup for the virtual page address.
-	     // This is slow, but the alternative is maintaining a full reverse lookup map.
-	     // Another alternative may be to make new FlashTransaction commands for physical address read/write.
-	     bool found = false;
-	     for (std::unordered_map<uint64_t, uint64_t>::iterator it = addressMap.begin(); it != addressMap.end(); it++) {
-		 tmpAddr = (*it).second;
-		 if (tmpAddr == pAddr) {
-		     vAddr = (*it).first;
-		     found = true;
-		     break;
-		 }
-	     }		assert(found);
+	     // Look up the virtual page address that lives here.
+	     vAddr = reverseMap[pAddr / NV_PAGE_SIZE];
+	     assert(vAddr != NO_MAPPING);
 
 	     // Schedule a read
 	     trans = FlashTransaction(GC_DATA_READ, vAddr, NULL);
@@ -470,31 +560,62 @@ void GCFtl::addGC(uint64_t dirty_block)
      }
 }
 
-void GCFtl::popFront(ChannelPacketType type)
+// fast forward version of the gc, the valid pages are moved and the block is erased right away
+void GCFtl::ff_gc(void)
 {
-    // if its a gc operation pop from the gc queue
-    if(type == ERASE || type == GC_READ || type == GC_WRITE)
-    {
-	gcQueue.pop_front();
-    }
-    // if we've put stuff into different queues we must now figure out which queue to pop from
-    else if(SCHEDULE)
-    {
-	if(type == READ)
-	{
-	    readQueue.pop_front();	
-	}
-	else if(type == WRITE)
-	{
-	    writeQueue.pop_front();
-	}
-    }
-    // if we're just putting everything into the read queue, just pop from there
-    // unless its a gc operation then pop from the gcQueue
-    else
-    {
-	readQueue.pop_front();
-    }
+     uint64_t w, valid, page, pAddr, vAddr, victim;
+
+     if (!pick_victim(&victim))
+	 return;
+
+     retire_block(victim);
+
+     for (w = 0; w < used.words(); w++) {
+	 valid = used.word(victim, w) & ~dirty.word(victim, w);
+	 while (valid != 0) {
+	     page = (w << 6) + __builtin_ctzll(valid);
+	     valid &= valid - 1;
+
+	     pAddr = (victim * BLOCK_SIZE + page * NV_PAGE_SIZE);
+	     vAddr = reverseMap[pAddr / NV_PAGE_SIZE];
+	     assert(vAddr != NO_MAPPING);
+
+	     if (!ff_write(vAddr))
+	     {
+		 ERROR("FLASH DIMM IS COMPLETELY FULL - there is no room left to move valid pages during fast forward gc.");
+		 exit(9001);
+	     }
+	 }
+     }
+
+     pAddr = victim * BLOCK_SIZE;
+     controller->eraseInPackage(Ftl::translate(ERASE, 0, pAddr, pAddr));
+     clean_block(victim);
+}
+
+// bookkeeping for a block that has just been erased
+void GCFtl::clean_block(uint64_t block)
+{
+     uint64_t i;
+
+     reclaim_block(block);
+
+     dirty_page_count -= dirty.count(block);
+     dirty.clear_block(block);
+     set_dirty_pages(block, 0);
+
+     used_page_count -= used.count(block);
+     free_block(block);
+
+     for (i = 0 ; i < PAGES_PER_BLOCK ; i++){
+	 reverseMap[(block * BLOCK_SIZE / NV_PAGE_SIZE) + i] = NO_MAPPING;
+     }
+}
+
+void GCFtl::pop_transaction(void)
+{
+    current->queue->erase(current->position);
+    sendQueueLength();
 }
 
 void GCFtl::sendQueueLength(void)
@@ -507,170 +628,147 @@ void GCFtl::sendQueueLength(void)
 
 void GCFtl::saveNVState(void)
 {
-     if(ENABLE_NV_SAVE && !saved)
+    if(parent->nv_save && !saved)
     {
-	ofstream save_file;
-	save_file.open(NV_SAVE_FILE, ios_base::out | ios_base::trunc);
-	if(!save_file)
-	{
-	    cout << "ERROR: Could not open NVDIMM state save file: " << NV_SAVE_FILE << "\n";
-	    abort();
-	}
-	
 	cout << "NVDIMM is saving the used table, dirty table and address map \n";
 
-	// save the address map
-	save_file << "AddressMap \n";
-	std::unordered_map<uint64_t, uint64_t>::iterator it;
-	for (it = addressMap.begin(); it != addressMap.end(); it++)
-	{
-	    save_file << (*it).first << " " << (*it).second << " \n";
-	}
-
-        // save the dirty table
-	save_file << "Dirty \n";
-	for(uint i = 0; i < dirty.size(); i++)
-	{
-	    for(uint j = 0; j < dirty[i].size(); j++)
-	    {
-		save_file << dirty[i][j] << " ";
-	    }
-	    save_file << "\n";
-	}
-
-	// save the used table
-	save_file << "Used";
-	for(uint i = 0; i < used.size(); i++)
-	{
-	    save_file << "\n";
-	    for(uint j = 0; j < used[i].size()-1; j++)
-	    {
-		save_file << used[i][j] << " ";
-	    }
-	    save_file << used[i][used[i].size()-1];
-	}
-
-	save_file.close();
+	Checkpoint::save(parent->nv_save_file, addressMap, used, &dirty);
 	saved = true;
     }
 }
 
 void GCFtl::loadNVState(void)
 {
-    if(ENABLE_NV_RESTORE && !loaded)
+    Ftl::loadNVState();
+    build_dirty_buckets();
+}
+
+void GCFtl::load_dirty(Checkpoint &checkpoint)
+{
+    if(checkpoint.hasDirty())
+    {
+	dirty.load(checkpoint.dirtyWords());
+    }
+}
+
+// importer for state files saved in the old text format
+void GCFtl::load_text_state(void)
+{
+    ifstream restore_file;
+    restore_file.open(parent->nv_restore_file);
+    if(!restore_file)
     {
-	ifstream restore_file;
-	restore_file.open(NV_RESTORE_FILE);
-	if(!restore_file)
+	cout << "ERROR: Could not open NVDIMM restore file: " << parent->nv_restore_file << "\n";
+	abort();
+    }
+
+    // restore the data
+    uint64_t doing_used = 0;
+    uint64_t doing_dirty = 0;
+    uint64_t doing_addresses = 0;
+    uint64_t row = 0;
+    uint64_t column = 0;
+    uint64_t first = 0;
+    uint64_t key = 0;
+    uint64_t pAddr = 0;
+    uint64_t vAddr = 0;
+
+    std::string temp;
+
+    while(!restore_file.eof())
+    { 
+	restore_file >> temp;
+	// don't process the last token a second time when we hit the end of the file
+	if(restore_file.fail())
 	{
-	    cout << "ERROR: Could not open NVDIMM restore file: " << NV_RESTORE_FILE << "\n";
-	    abort();
+	    break;
 	}
 
-	cout << "NVDIMM is restoring the system from file " << NV_RESTORE_FILE <<"\n";
+	// these comparisons make this parser work but they are dependent on the ordering of the data in the state file
+	// if the state file changes these comparisons may also need to be changed
+	if(temp.compare("Used") == 0)
+	{
+	    doing_used = 1;
+	    doing_addresses = 0;
+	    doing_dirty = 0;
 
-	// restore the data
-	uint64_t doing_used = 0;
-	uint64_t doing_dirty = 0;
-	uint64_t doing_addresses = 0;
-	uint64_t row = 0;
-	uint64_t column = 0;
-	uint64_t first = 0;
-	uint64_t key = 0;
-	uint64_t pAddr = 0;
-	uint64_t vAddr = 0;
+	    row = 0;
+	    column = 0;
+	}
+	else if(temp.compare("Dirty") == 0)
+	{
+	    doing_used = 0;
+	    doing_dirty = 1;
+	    doing_addresses = 0;
 
-	std::unordered_map<uint64_t,uint64_t> tempMap;
+	    row = 0;
+	    column = 0;
+	}
+	else if(temp.compare("AddressMap") == 0)
+	{
+	    doing_used = 0;
+	    doing_dirty = 0;
+	    doing_addresses = 1;
 
-	std::string temp;
-	
-	while(!restore_file.eof())
-	{ 
-	    restore_file >> temp;
-	    
-	    // these comparisons make this parser work but they are dependent on the ordering of the data in the state file
-	    // if the state file changes these comparisons may also need to be changed
-	    if(temp.compare("Used") == 0)
+	    row = 0;
+	    column = 0;
+	}
+	// restore used data
+	else if(doing_used == 1)
+	{
+	    if(convert_uint64_t(temp))
+		used.set(row, column);
+	    else
+		used.clear(row, column);
+
+	    // this page was used need to issue fake write
+	    if(temp.compare("1") == 0 && !dirty.get(row, column))
 	    {
-		doing_used = 1;
-		doing_addresses = 0;
-		doing_dirty = 0;
-		
-		row = 0;
-		column = 0;
-	    }
-	    else if(temp.compare("Dirty") == 0)
+		pAddr = (row * BLOCK_SIZE + column * NV_PAGE_SIZE);
+		vAddr = reverseMap[pAddr / NV_PAGE_SIZE];
+		ChannelPacket *tempPacket = Ftl::translate(WRITE, 0, vAddr, pAddr);
+		controller->writeToPackage(tempPacket);
+	    }		
+
+	    column++;
+	    if(column >= PAGES_PER_BLOCK)
 	    {
-		doing_used = 0;
-		doing_dirty = 1;
-		doing_addresses = 0;
-		
-		row = 0;
+		row++;
 		column = 0;
 	    }
-	    else if(temp.compare("AddressMap") == 0)
+	}
+	// restore dirty data
+	else if(doing_dirty == 1)
+	{
+	    if(convert_uint64_t(temp))
+		dirty.set(row, column);
+	    else
+		dirty.clear(row, column);
+	    column++;
+	    if(column >= PAGES_PER_BLOCK)
 	    {
-		doing_used = 0;
-		doing_dirty = 0;
-		doing_addresses = 1;
-
-		row = 0;
+		row++;
 		column = 0;
 	    }
-	    // restore used data
-	    else if(doing_used == 1)
+	}
+	// restore address map data
+	else if(doing_addresses == 1)
+	{	
+	    if(first == 0)
 	    {
-		used[row][column] = convert_uint64_t(temp);
-
-                // this page was used need to issue fake write
-		if(temp.compare("1") == 0 && dirty[row][column] != 1)
-		{
-		    pAddr = (row * BLOCK_SIZE + column * NV_PAGE_SIZE);
-		    vAddr = tempMap[pAddr];
-		    ChannelPacket *tempPacket = Ftl::translate(WRITE, vAddr, pAddr);
-		    controller->writeToPackage(tempPacket);
-
-		    used_page_count++;
-		}		
-
-		column++;
-		if(column >= PAGES_PER_BLOCK)
-		{
-		    row++;
-		    column = 0;
-		}
+		first = 1;
+		key = convert_uint64_t(temp);
 	    }
-	    // restore dirty data
-	    else if(doing_dirty == 1)
+	    else
 	    {
-		dirty[row][column] = convert_uint64_t(temp);
-		column++;
-		if(column >= PAGES_PER_BLOCK)
-		{
-		    row++;
-		    column = 0;
-		}
+		addressMap.map(key, convert_uint64_t(temp));
+		reverseMap[convert_uint64_t(temp) / NV_PAGE_SIZE] = key;
+		first = 0;
 	    }
-	    // restore address map data
-	    else if(doing_addresses == 1)
-	    {	
-		if(first == 0)
-		{
-		    first = 1;
-		    key = convert_uint64_t(temp);
-		}
-		else
-		{
-		    addressMap[key] = convert_uint64_t(temp);
-		    tempMap[convert_uint64_t(temp)] = key;
-		    first = 0;
-		}
-	    }   
-	}
-
-	restore_file.close();
-	loaded = true;
+	}   
     }
+
+    restore_file.close();
 }
 
 void GCFtl::GCReadDone(uint64_t vAddr)
@@ -46,6 +46,7 @@
 #include "Ftl.h"
 #include "Logger.h"
 #include "GCLogger.h"
+#include "PageBitmap.h"
 
 namespace NVDSim{
         class NVDIMM;
@@ -54,27 +55,37 @@ namespace NVDSim{
 	                GCFtl(Controller *c, Logger *l, NVDIMM *p);
 			bool addTransaction(FlashTransaction &t);
 			void addGcTransaction(FlashTransaction &t);
+			void addFfTransaction(FlashTransaction &t);
 			void update(void);
+			uint64_t nextEvent(void);
 			void write_used_handler(uint64_t vAddr);
 			bool checkGC(void); 
 			void runGC(void);
-			void runGC(uint64_t plane);
+			bool runGC(uint64_t plane);
+			bool pick_victim(uint64_t *block);
 			void addGC(uint64_t dirty_block);
+			void ff_gc(void);
+			void clean_block(uint64_t block);
 
-			void popFront(ChannelPacketType type);
+			void build_dirty_buckets(void);
+			void set_dirty_pages(uint64_t block, uint64_t count);
+
+			void pop_transaction(void);
 
 			void sendQueueLength(void);
 
 			void saveNVState(void);
 			void loadNVState(void);
+			void load_dirty(Checkpoint &checkpoint);
+			void load_text_state(void);
 
 			void GCReadDone(uint64_t vAddr);
 
 		protected:
 			uint gc_status, panic_mode;
-			uint64_t start_erase;
+			uint64_t start_erase, panic_erases;
 
-			uint erase_pointer;			
+			uint erase_pointer; //plane to start looking for the dirtiest block on
 			
 			class PendingErase
 			{
@@ -91,7 +102,13 @@ namespace NVDSim{
 
 			uint64_t dirty_page_count;
 
-			std::vector<vector<bool>> dirty;
+			PageBitmap dirty;
+
+			// blocks are kept in buckets by their number of dirty pages so the dirtiest block in a plane can be found right away
+			std::vector<uint64_t> dirty_pages; //per block, the bucket it is filed under
+			std::vector<std::vector<std::list<uint64_t> > > dirty_buckets; //per plane, one bucket for each dirty page count
+			std::vector<std::list<uint64_t>::iterator> bucket_position; //per block, where it is in its bucket
+			std::vector<uint64_t> max_dirty; //per plane, dirty page count of the dirtiest block
 			std::list<FlashTransaction> gcQueue;
 	};
 }
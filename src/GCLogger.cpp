@@ -53,29 +53,9 @@ GCLogger::GCLogger()
 	erase_energy = vector<double>(NUM_PACKAGES, 0.0); 
 }
 
-void GCLogger::update()
+void GCLogger::access_stop(uint64_t id)
 {
-    	//update idle energy
-	//since this is already subtracted from the access energies we just do it every time
-	for(uint i = 0; i < (NUM_PACKAGES); i++)
-	{
-	  idle_energy[i] += STANDBY_I;
-	}
-
-	this->step();
-}
-
-void GCLogger::access_stop(uint64_t addr, uint64_t paddr)
-{
-        if (access_map[addr][paddr].empty())
-	{
-	    cerr << "ERROR: NVGCLogger.access_stop() called with address not in access_map. address= " << hex << addr << ", " << paddr << "\n" << dec;
-		abort();
-	}
-
-	AccessMapEntry a = access_map[addr][paddr].front();
-	a.stop = this->currentClockCycle;
-	access_map[addr][paddr].front() = a;
+	AccessMapEntry &a = stop_entry(id, "NVGCLogger");
 
 	// Log cache event type.
 	if (a.op == READ)
@@ -135,16 +115,9 @@ void GCLogger::access_stop(uint64_t addr, uint64_t paddr)
 		}
 	    }
 	}
-	
-	access_map[addr][paddr].pop_front();
-	if(access_map[addr][paddr].empty())
-	{
-	    access_map[addr].erase(paddr);
-	    if(access_map.count(addr) == 0)
-	    {
-		access_map.erase(addr);
-	    }
-	}
+
+	record_latency(a);
+	end_access(a);
 }
 
 void GCLogger::erase()
@@ -178,33 +151,32 @@ void GCLogger::gcwrite_latency(uint64_t cycles)
 	average_gcwrite_latency += cycles;
 }
 
-void GCLogger::ftlQueueLength(uint64_t length, uint64_t length2)
+void GCLogger::settle_queue_lengths(void)
 {
-    if(length > ftl_queue_length){
-	ftl_queue_length = length;
-    }
-
-    if(length > max_ftl_queue_length){
-	max_ftl_queue_length = length;
-    }
-
-    if(length2 > gc_queue_length){
-	gc_queue_length = length2;
-    }
+    Logger::settle_queue_lengths();
+    settle_queue(gc_queue, gc_queue_length, max_gc_queue_length);
+}
 
-    if(length2 > max_gc_queue_length){
-	max_gc_queue_length = length2;
-    }
+void GCLogger::ftlQueueLength(uint64_t length, uint64_t length2)
+{
+    Logger::ftlQueueLength(length);
+    settle_queue(gc_queue, gc_queue_length, max_gc_queue_length);
+    gc_queue.length = length2;
 }
 
 void GCLogger::ftlQueueReset()
 {
-    ftl_queue_length = 0;
+    Logger::ftlQueueReset();
+    settle_queue(gc_queue, gc_queue_length, max_gc_queue_length);
     gc_queue_length = 0;
+    gc_queue.epoch_integral = 0;
 }
 
 void GCLogger::save(uint64_t cycle, uint epoch) 
 {
+	settle_idle_energy();
+	settle_queue_lengths();
+
         // Power stuff
 	// Total power used
 	vector<double> total_energy = vector<double>(NUM_PACKAGES, 0.0);
@@ -235,14 +207,14 @@ void GCLogger::save(uint64_t cycle, uint epoch)
 	    }
 	}
 
-	string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
+	string command_str = "test -e "+log_dir+" || mkdir "+log_dir;
 	const char * command = command_str.c_str();
 	int sys_done = system(command);
 	if (sys_done != 0)
 	{
 	    WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
 	}
-	savefile.open(LOG_DIR+"NVDIMM.log", ios_base::out | ios_base::trunc);
+	savefile.open(log_dir+"NVDIMM.log", ios_base::out | ios_base::trunc);
 	savefile<<"NVDIMM Log \n";
 
 	if (!savefile) 
@@ -290,13 +262,18 @@ void GCLogger::save(uint64_t cycle, uint epoch)
 	savefile<<"Read Throughput: " <<this->calc_throughput(cycle, num_reads)<<" KB/sec\n";
 	savefile<<"Write Throughput: " <<this->calc_throughput(cycle, num_writes)<<" KB/sec\n";
 
+	write_latency_percentiles(latency_histograms, NUM_PACKAGES);
+
 	savefile<<"\nQueue Length Data: \n";
 	savefile<<"========================\n";
 	savefile<<"Maximum Length of Ftl Queue: " <<max_ftl_queue_length<<"\n";
+	savefile<<"Average Length of Ftl Queue: " <<divide((double)ftl_queue.integral, (double)cycle)<<"\n";
 	savefile<<"Maximum Length of GC Queue: " <<max_gc_queue_length<<"\n";
+	savefile<<"Average Length of GC Queue: " <<divide((double)gc_queue.integral, (double)cycle)<<"\n";
 	for(uint i = 0; i < ctrl_queue_length.size(); i++)
 	{
 	    savefile<<"Maximum Length of Controller Queue for Package " << i << ": "<<max_ctrl_queue_length[i]<<"\n";
+	    savefile<<"Average Length of Controller Queue for Package " << i << ": "<<divide((double)ctrl_queue[i].integral, (double)cycle)<<"\n";
 	}
 
 	if(WEAR_LEVEL_LOG)
@@ -342,6 +319,8 @@ void GCLogger::save(uint64_t cycle, uint epoch)
 }
 
 void GCLogger::print(uint64_t cycle) {
+	settle_idle_energy();
+
 	// Power stuff
 	// Total power used
 	vector<double> total_energy = vector<double>(NUM_PACKAGES, 0.0); 
@@ -387,6 +366,8 @@ void GCLogger::print(uint64_t cycle) {
 
 vector<vector<double> > GCLogger::getEnergyData(void)
 {
+    settle_idle_energy();
+
     vector<vector<double> > temp = vector<vector<double> >(3, vector<double>(NUM_PACKAGES, 0.0));
     for(uint i = 0; i < NUM_PACKAGES; i++)
     {
@@ -397,8 +378,28 @@ vector<vector<double> > GCLogger::getEnergyData(void)
     return temp;
 }
 
+const vector<double> *GCLogger::getEnergyField(PowerField field)
+{
+    settle_idle_energy();
+
+    switch (field)
+    {
+    case IDLE_ENERGY:
+	return &idle_energy;
+    case ACCESS_ENERGY:
+	return &access_energy;
+    case ERASE_ENERGY:
+	return &erase_energy;
+    default:
+	return NULL;
+    }
+}
+
 void GCLogger::save_epoch(uint64_t cycle, uint epoch)
 {    
+    settle_idle_energy();
+    settle_queue_lengths();
+
     EpochEntry this_epoch;
     this_epoch.cycle = cycle;
     this_epoch.epoch = epoch;
@@ -427,13 +428,16 @@ void GCLogger::save_epoch(uint64_t cycle, uint epoch)
     this_epoch.average_queue_latency = average_queue_latency;
 
     this_epoch.ftl_queue_length = ftl_queue_length;
+    this_epoch.ftl_queue_integral = ftl_queue.epoch_integral;
     this_epoch.gc_queue_length = gc_queue_length;
+    this_epoch.gc_queue_integral = gc_queue.epoch_integral;
 
     this_epoch.writes_per_address = writes_per_address;
 
     for(uint i = 0; i < ctrl_queue_length.size(); i++)
     {
 	this_epoch.ctrl_queue_length[i] = ctrl_queue_length[i];
+	this_epoch.ctrl_queue_integral[i] = ctrl_queue[i].epoch_integral;
     }
 
     for(uint i = 0; i < NUM_PACKAGES; i++)
@@ -442,6 +446,8 @@ void GCLogger::save_epoch(uint64_t cycle, uint epoch)
 	this_epoch.access_energy[i] = access_energy[i]; 
     }
 
+    take_epoch_latencies(this_epoch.latency_histograms);
+
     EpochEntry temp_epoch;
 
     temp_epoch = this_epoch;
@@ -497,19 +503,19 @@ void GCLogger::write_epoch(EpochEntry *e)
 {
     	if(e->epoch == 0 && RUNTIME_WRITE)
 	{
-	    string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
+	    string command_str = "test -e "+log_dir+" || mkdir "+log_dir;
 	    const char * command = command_str.c_str();
 	    int sys_done = system(command);
 	    if (sys_done != 0)
 	    {
 		WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
 	    }
-	    savefile.open(LOG_DIR+"NVDIMM_EPOCH.log", ios_base::out | ios_base::trunc);
+	    savefile.open(log_dir+"NVDIMM_EPOCH.log", ios_base::out | ios_base::trunc);
 	    savefile<<"NVDIMM_EPOCH Log \n";
 	}
 	else
 	{
-	    savefile.open(LOG_DIR+"NVDIMM_EPOCH.log", ios_base::out | ios_base::app);
+	    savefile.open(log_dir+"NVDIMM_EPOCH.log", ios_base::out | ios_base::app);
 	}
 
 	if (!savefile) 
@@ -584,13 +590,18 @@ void GCLogger::write_epoch(EpochEntry *e)
 	savefile<<"Read Throughput: " <<this->calc_throughput(e->cycle, e->num_reads)<<" KB/sec\n";
 	savefile<<"Write Throughput: " <<this->calc_throughput(e->cycle, e->num_writes)<<" KB/sec\n";
 
+	write_latency_percentiles(e->latency_histograms, 1);
+
 	savefile<<"\nQueue Length Data: \n";
 	savefile<<"========================\n";
 	savefile<<"Length of Ftl Queue: " <<e->ftl_queue_length<<"\n";
+	savefile<<"Average Length of Ftl Queue: " <<divide((double)e->ftl_queue_integral, (double)e->cycle)<<"\n";
 	savefile<<"Length of GC Queue: " <<e->gc_queue_length<<"\n";
+	savefile<<"Average Length of GC Queue: " <<divide((double)e->gc_queue_integral, (double)e->cycle)<<"\n";
 	for(uint i = 0; i < e->ctrl_queue_length.size(); i++)
 	{
 	    savefile<<"Length of Controller Queue for Package " << i << ": "<<e->ctrl_queue_length[i]<<"\n";
+	    savefile<<"Average Length of Controller Queue for Package " << i << ": "<<divide((double)e->ctrl_queue_integral[i], (double)e->cycle)<<"\n";
 	}
 
 	if(WEAR_LEVEL_LOG)
@@ -0,0 +1,92 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVHOSTINTERFACE_H
+#define NVHOSTINTERFACE_H
+//HostInterface.h
+//plain structs passed between the NVDIMM and the host, see NVDIMMSim.h
+
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace NVDSim
+{
+	// one request of a batch given to NVDIMM::addBatch
+	struct HostRequest
+	{
+		uint64_t address;
+		bool isWrite;
+		uint64_t id; // filled in if the request is accepted
+	};
+
+	enum CompletionType
+	{
+		READ_COMPLETION,
+		CRIT_LINE_COMPLETION,
+		WRITE_COMPLETION
+	};
+
+	// one entry of the completion ring, these are the same things the callbacks are given
+	struct Completion
+	{
+		uint64_t id;
+		uint64_t address;
+		uint64_t cycle;
+		CompletionType type;
+		bool mapped;
+	};
+
+	// the energy columns the loggers keep, not every device has all of them
+	enum PowerField
+	{
+		IDLE_ENERGY,
+		ACCESS_ENERGY,
+		ERASE_ENERGY,
+		VPP_IDLE_ENERGY,
+		VPP_ACCESS_ENERGY,
+		VPP_ERASE_ENERGY,
+		NUM_POWER_FIELDS
+	};
+
+	// Power telemetry for all of the packages. The arrays are owned by the NVDIMM and refilled in place
+	// each time the data is asked for, energy[f] is NULL for the fields this device doesn't have.
+	// Like the power callback the values are already scaled by VCC or VPP.
+	struct PowerData
+	{
+		uint64_t cycle;
+		uint num_packages;
+		double *energy[NUM_POWER_FIELDS];
+	};
+}
+
+#endif
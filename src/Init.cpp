@@ -31,166 +31,102 @@
 *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *********************************************************************************/
 
+// Init fills in the members of a Config by name, see FlashConfiguration.h
+#define NO_CONFIG_MACROS
 #include "Init.h"
 
 using namespace std;
 
-// these are the values that are extern'd in FlashConfiguration.h so that they
-// have global scope even though they are set by Init
-
 namespace NVDSim 
 {
 
-bool SCHEDULE;
-bool WRITE_ON_QUEUE_SIZE;
-uint WRITE_QUEUE_LIMIT;
-bool IDLE_WRITE;
-bool CTRL_SCHEDULE;
-bool CTRL_WRITE_ON_QUEUE_SIZE;
-uint CTRL_WRITE_QUEUE_LIMIT;
-bool CTRL_IDLE_WRITE;
-
-bool BUFFERED;
-uint64_t IN_BUFFER_SIZE;
-uint64_t OUT_BUFFER_SIZE;
-
-bool CRIT_LINE_FIRST;
-
-bool LOGGING;
-std::string LOG_DIR;
-bool WEAR_LEVEL_LOG;
-bool RUNTIME_WRITE; 
-bool PER_PACKAGE;
-bool QUEUE_EVENT_LOG;
-bool PLANE_STATE_LOG;
-
-bool ENABLE_NV_SAVE;
-std::string NV_SAVE_FILE;
-bool ENABLE_NV_RESTORE;
-std::string NV_RESTORE_FILE;
-
-std::string DEVICE_TYPE;
-uint64_t NUM_PACKAGES;
-uint64_t DIES_PER_PACKAGE;
-uint64_t PLANES_PER_DIE;
-uint64_t BLOCKS_PER_PLANE;
-uint64_t VIRTUAL_BLOCKS_PER_PLANE;
-uint64_t PAGES_PER_BLOCK;
-uint64_t NV_PAGE_SIZE;
-float DEVICE_CYCLE;
-float CHANNEL_CYCLE;
-uint64_t DEVICE_WIDTH;
-uint64_t CHANNEL_WIDTH;
-
-bool GARBAGE_COLLECT;
-
-uint READ_TIME;
-uint WRITE_TIME;
-uint ERASE_TIME;
-uint COMMAND_LENGTH;
-uint LOOKUP_TIME;
-uint QUEUE_ACCESS_TIME;
-uint EPOCH_TIME;
-float CYCLE_TIME;
-
-uint FTL_READ_QUEUE_LENGTH;
-uint CTRL_READ_QUEUE_LENGTH;
-uint FTL_WRITE_QUEUE_LENGTH;
-uint CTRL_WRITE_QUEUE_LENGTH;
-
-double READ_I;
-double WRITE_I;
-double ERASE_I;
-double STANDBY_I;
-double IN_LEAK_I;
-double OUT_LEAK_I;
-double VCC;
-double ASYNC_READ_I;
-double VPP_STANDBY_I;
-double VPP_READ_I;
-double VPP_WRITE_I;
-double VPP_ERASE_I;
-double VPP;
-
-float IDLE_GC_THRESHOLD;
-float FORCE_GC_THRESHOLD;
-float PBLOCKS_PER_VBLOCK;
+thread_local const Config *current_config = NULL;
 
 uint DEBUG_INIT= 0;
 
 //namespace NVDSim 
 //{
 		
-	//Map the string names to the variables they set
-	static ConfigMap configMap[] = {
-		//DEFINE_UINT_PARAM -- see Init.h
-	        DEFINE_BOOL_PARAM(SCHEDULE, DEV_PARAM),
-	        DEFINE_BOOL_PARAM(WRITE_ON_QUEUE_SIZE, DEV_PARAM),
-		DEFINE_UINT_PARAM(WRITE_QUEUE_LIMIT, DEV_PARAM),
-		DEFINE_BOOL_PARAM(IDLE_WRITE, DEV_PARAM),
-		DEFINE_BOOL_PARAM(CTRL_SCHEDULE, DEV_PARAM),
-	        DEFINE_BOOL_PARAM(CTRL_WRITE_ON_QUEUE_SIZE, DEV_PARAM),
-		DEFINE_UINT_PARAM(CTRL_WRITE_QUEUE_LIMIT, DEV_PARAM),
-		DEFINE_BOOL_PARAM(CTRL_IDLE_WRITE, DEV_PARAM),
-	        DEFINE_BOOL_PARAM(BUFFERED, DEV_PARAM),
-	        DEFINE_UINT64_PARAM(IN_BUFFER_SIZE, DEV_PARAM),
-	        DEFINE_UINT64_PARAM(OUT_BUFFER_SIZE, DEV_PARAM),
-		DEFINE_BOOL_PARAM(CRIT_LINE_FIRST, DEV_PARAM),
-		DEFINE_BOOL_PARAM(LOGGING, DEV_PARAM),
-		DEFINE_STRING_PARAM(LOG_DIR, DEV_PARAM),
-	        DEFINE_BOOL_PARAM(WEAR_LEVEL_LOG, DEV_PARAM),
-		DEFINE_BOOL_PARAM(RUNTIME_WRITE, DEV_PARAM),
-		DEFINE_BOOL_PARAM(PER_PACKAGE, DEV_PARAM),
-		DEFINE_BOOL_PARAM(QUEUE_EVENT_LOG, DEV_PARAM),
-		DEFINE_BOOL_PARAM(PLANE_STATE_LOG, DEV_PARAM),
-		DEFINE_BOOL_PARAM(ENABLE_NV_SAVE, DEV_PARAM),
-		DEFINE_STRING_PARAM(NV_SAVE_FILE, DEV_PARAM),
-		DEFINE_BOOL_PARAM(ENABLE_NV_RESTORE, DEV_PARAM),
-		DEFINE_STRING_PARAM(NV_RESTORE_FILE, DEV_PARAM),
-	        DEFINE_STRING_PARAM(DEVICE_TYPE, DEV_PARAM),
-		DEFINE_UINT64_PARAM(NUM_PACKAGES,DEV_PARAM),
-		DEFINE_UINT64_PARAM(DIES_PER_PACKAGE,DEV_PARAM),
-		DEFINE_UINT64_PARAM(PLANES_PER_DIE,DEV_PARAM),
-		//DEFINE_UINT64_PARAM(BLOCKS_PER_PLANE,DEV_PARAM),
-		DEFINE_UINT64_PARAM(VIRTUAL_BLOCKS_PER_PLANE,DEV_PARAM),
-		DEFINE_UINT64_PARAM(PAGES_PER_BLOCK,DEV_PARAM),
-		DEFINE_UINT64_PARAM(NV_PAGE_SIZE,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(DEVICE_CYCLE,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(CHANNEL_CYCLE,DEV_PARAM),
-		DEFINE_UINT64_PARAM(DEVICE_WIDTH,DEV_PARAM),
-		DEFINE_UINT64_PARAM(CHANNEL_WIDTH,DEV_PARAM),
-		DEFINE_BOOL_PARAM(GARBAGE_COLLECT,DEV_PARAM),
-		DEFINE_UINT_PARAM(READ_TIME,DEV_PARAM),
-		DEFINE_UINT_PARAM(WRITE_TIME,DEV_PARAM),
-		DEFINE_UINT_PARAM(ERASE_TIME,DEV_PARAM),
-		DEFINE_UINT_PARAM(COMMAND_LENGTH,DEV_PARAM),
-		DEFINE_UINT_PARAM(LOOKUP_TIME,DEV_PARAM),
-		DEFINE_UINT_PARAM(QUEUE_ACCESS_TIME,DEV_PARAM),
-		DEFINE_UINT_PARAM(EPOCH_TIME,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(CYCLE_TIME,DEV_PARAM),
-		DEFINE_UINT_PARAM(FTL_READ_QUEUE_LENGTH,DEV_PARAM),
-		DEFINE_UINT_PARAM(CTRL_READ_QUEUE_LENGTH,DEV_PARAM),
-		DEFINE_UINT_PARAM(FTL_WRITE_QUEUE_LENGTH,DEV_PARAM),
-		DEFINE_UINT_PARAM(CTRL_WRITE_QUEUE_LENGTH,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(READ_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(WRITE_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(ERASE_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(STANDBY_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(IN_LEAK_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(OUT_LEAK_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(VCC,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(ASYNC_READ_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(VPP_STANDBY_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(VPP_READ_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(VPP_WRITE_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(VPP_ERASE_I,DEV_PARAM),
-		DEFINE_DOUBLE_PARAM(VPP,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(IDLE_GC_THRESHOLD,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(FORCE_GC_THRESHOLD,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(PBLOCKS_PER_VBLOCK,DEV_PARAM),
-
-		{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
-	};
+	Init::Init(Config *c)
+	{
+		config = c;
+
+		//Map the string names to the variables they set
+		ConfigMap map[] = {
+			//DEFINE_UINT_PARAM -- see Init.h
+			DEFINE_UINT_PARAM(PARALLEL_THREADS, DEV_PARAM),
+		        DEFINE_BOOL_PARAM(SCHEDULE, DEV_PARAM),
+		        DEFINE_BOOL_PARAM(WRITE_ON_QUEUE_SIZE, DEV_PARAM),
+			DEFINE_UINT_PARAM(WRITE_QUEUE_LIMIT, DEV_PARAM),
+			DEFINE_BOOL_PARAM(IDLE_WRITE, DEV_PARAM),
+			DEFINE_BOOL_PARAM(CTRL_SCHEDULE, DEV_PARAM),
+		        DEFINE_BOOL_PARAM(CTRL_WRITE_ON_QUEUE_SIZE, DEV_PARAM),
+			DEFINE_UINT_PARAM(CTRL_WRITE_QUEUE_LIMIT, DEV_PARAM),
+			DEFINE_BOOL_PARAM(CTRL_IDLE_WRITE, DEV_PARAM),
+			DEFINE_UINT_PARAM(CTRL_SCHEDULE_WINDOW, DEV_PARAM),
+			DEFINE_UINT_PARAM(CTRL_SCHEDULE_AGE, DEV_PARAM),
+		        DEFINE_BOOL_PARAM(BUFFERED, DEV_PARAM),
+		        DEFINE_UINT64_PARAM(IN_BUFFER_SIZE, DEV_PARAM),
+		        DEFINE_UINT64_PARAM(OUT_BUFFER_SIZE, DEV_PARAM),
+			DEFINE_BOOL_PARAM(CRIT_LINE_FIRST, DEV_PARAM),
+			DEFINE_BOOL_PARAM(LOGGING, DEV_PARAM),
+			DEFINE_STRING_PARAM(LOG_DIR, DEV_PARAM),
+		        DEFINE_BOOL_PARAM(WEAR_LEVEL_LOG, DEV_PARAM),
+			DEFINE_BOOL_PARAM(RUNTIME_WRITE, DEV_PARAM),
+			DEFINE_BOOL_PARAM(PER_PACKAGE, DEV_PARAM),
+			DEFINE_BOOL_PARAM(QUEUE_EVENT_LOG, DEV_PARAM),
+			DEFINE_BOOL_PARAM(PLANE_STATE_LOG, DEV_PARAM),
+			DEFINE_BOOL_PARAM(ENABLE_NV_SAVE, DEV_PARAM),
+			DEFINE_STRING_PARAM(NV_SAVE_FILE, DEV_PARAM),
+			DEFINE_BOOL_PARAM(ENABLE_NV_RESTORE, DEV_PARAM),
+			DEFINE_STRING_PARAM(NV_RESTORE_FILE, DEV_PARAM),
+		        DEFINE_STRING_PARAM(DEVICE_TYPE, DEV_PARAM),
+			DEFINE_UINT64_PARAM(NUM_PACKAGES,DEV_PARAM),
+			DEFINE_UINT64_PARAM(DIES_PER_PACKAGE,DEV_PARAM),
+			DEFINE_UINT64_PARAM(PLANES_PER_DIE,DEV_PARAM),
+			//DEFINE_UINT64_PARAM(BLOCKS_PER_PLANE,DEV_PARAM),
+			DEFINE_UINT64_PARAM(VIRTUAL_BLOCKS_PER_PLANE,DEV_PARAM),
+			DEFINE_UINT64_PARAM(PAGES_PER_BLOCK,DEV_PARAM),
+			DEFINE_UINT64_PARAM(NV_PAGE_SIZE,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(DEVICE_CYCLE,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(CHANNEL_CYCLE,DEV_PARAM),
+			DEFINE_UINT64_PARAM(DEVICE_WIDTH,DEV_PARAM),
+			DEFINE_UINT64_PARAM(CHANNEL_WIDTH,DEV_PARAM),
+			DEFINE_BOOL_PARAM(GARBAGE_COLLECT,DEV_PARAM),
+			DEFINE_UINT_PARAM(READ_TIME,DEV_PARAM),
+			DEFINE_UINT_PARAM(WRITE_TIME,DEV_PARAM),
+			DEFINE_UINT_PARAM(ERASE_TIME,DEV_PARAM),
+			DEFINE_UINT_PARAM(COMMAND_LENGTH,DEV_PARAM),
+			DEFINE_UINT_PARAM(LOOKUP_TIME,DEV_PARAM),
+			DEFINE_UINT_PARAM(FTL_LOOKUP_ENGINES,DEV_PARAM),
+			DEFINE_UINT_PARAM(QUEUE_ACCESS_TIME,DEV_PARAM),
+			DEFINE_UINT_PARAM(EPOCH_TIME,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(CYCLE_TIME,DEV_PARAM),
+			DEFINE_UINT_PARAM(FTL_READ_QUEUE_LENGTH,DEV_PARAM),
+			DEFINE_UINT_PARAM(CTRL_READ_QUEUE_LENGTH,DEV_PARAM),
+			DEFINE_UINT_PARAM(FTL_WRITE_QUEUE_LENGTH,DEV_PARAM),
+			DEFINE_UINT_PARAM(CTRL_WRITE_QUEUE_LENGTH,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(READ_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(WRITE_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(ERASE_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(STANDBY_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(IN_LEAK_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(OUT_LEAK_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(VCC,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(ASYNC_READ_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(VPP_STANDBY_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(VPP_READ_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(VPP_WRITE_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(VPP_ERASE_I,DEV_PARAM),
+			DEFINE_DOUBLE_PARAM(VPP,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(IDLE_GC_THRESHOLD,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(FORCE_GC_THRESHOLD,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(PBLOCKS_PER_VBLOCK,DEV_PARAM),
+	
+			{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
+		};
+		configMap.assign(map, map + sizeof(map)/sizeof(map[0]));
+	}
 
 	void Init::WriteValuesOut(std::ofstream &visDataOut) 
 	{
@@ -332,6 +268,18 @@ uint DEBUG_INIT= 0;
 		}
 	}
 
+	bool Init::HasKey(string key)
+	{
+		for (size_t i=0; configMap[i].variablePtr != NULL; i++) 
+		{
+			if (key.compare(configMap[i].iniKey) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	void Init::ReadIniFile(string filename, bool isSystemFile)
 	{
 		ifstream iniFile;
@@ -395,7 +343,7 @@ uint DEBUG_INIT= 0;
 				// all characters after the equals are the value
 				valueString = line.substr(equalsIndex+1,strlen-equalsIndex);
 				
-				Init::SetKey(key, valueString, lineNumber, isSystemFile);
+				SetKey(key, valueString, lineNumber, isSystemFile);
 				// got to the end of the config map without finding the key
 			}
 		}
@@ -413,7 +361,14 @@ uint DEBUG_INIT= 0;
 			exit(-1);
 		}
 		for (size_t i=0; i<keys.size(); i++) {
-			Init::SetKey(keys[i], values[i]);
+			SetKey(keys[i], values[i]);
+		}
+	}
+
+	void Init::CopySetKeys(const Init &other)
+	{
+		for (size_t i=0; i<configMap.size(); i++) {
+			configMap[i].wasSet = other.configMap[i].wasSet;
 		}
 	}
 
@@ -431,7 +386,11 @@ uint DEBUG_INIT= 0;
 					    if (configMap[i].iniKey.compare((std::string)"EPOCH_TIME") == 0 ||
 					        configMap[i].iniKey.compare((std::string)"FTL_QUEUE_LENGTH") == 0 ||
 						configMap[i].iniKey.compare((std::string)"CTRL_QUEUE_LENGTH") == 0 ||
-						configMap[i].iniKey.compare((std::string)"WRITE_QUEUE_LIMIT") == 0)
+						configMap[i].iniKey.compare((std::string)"WRITE_QUEUE_LIMIT") == 0 ||
+						configMap[i].iniKey.compare((std::string)"PARALLEL_THREADS") == 0 ||
+						configMap[i].iniKey.compare((std::string)"FTL_LOOKUP_ENGINES") == 0 ||
+						configMap[i].iniKey.compare((std::string)"CTRL_SCHEDULE_WINDOW") == 0 ||
+						configMap[i].iniKey.compare((std::string)"CTRL_SCHEDULE_AGE") == 0)
 					    {
 						*((uint *)configMap[i].variablePtr) = 0;
 						DEBUG("\tSetting Default: "<<configMap[i].iniKey<<"=0");
@@ -468,6 +427,8 @@ uint DEBUG_INIT= 0;
 				}
 			}
 		}
+
+		config->BLOCKS_PER_PLANE = (uint64_t) config->VIRTUAL_BLOCKS_PER_PLANE * config->PBLOCKS_PER_VBLOCK;
 		return true;
 	}
 	/*unecessary right now
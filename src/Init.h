@@ -43,12 +43,13 @@
 using namespace std;
 
 // Uhhh, apparently the #name equals "name" -- HOORAY MACROS!
-#define DEFINE_UINT_PARAM(name, paramtype) {#name, &name, UINT, paramtype, false}
-#define DEFINE_STRING_PARAM(name, paramtype) {#name, &name, STRING, paramtype, false}
-#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &name, FLOAT, paramtype, false}
-#define DEFINE_DOUBLE_PARAM(name,paramtype) {#name, &name, DOUBLE, paramtype, false}
-#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &name, BOOL, paramtype, false}
-#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &name, UINT64, paramtype, false}
+// these point into the Config that this Init is filling in
+#define DEFINE_UINT_PARAM(name, paramtype) {#name, &config->name, UINT, paramtype, false}
+#define DEFINE_STRING_PARAM(name, paramtype) {#name, &config->name, STRING, paramtype, false}
+#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &config->name, FLOAT, paramtype, false}
+#define DEFINE_DOUBLE_PARAM(name,paramtype) {#name, &config->name, DOUBLE, paramtype, false}
+#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &config->name, BOOL, paramtype, false}
+#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &config->name, UINT64, paramtype, false}
 
 namespace NVDSim 
 {
@@ -65,17 +66,27 @@ namespace NVDSim
 		bool wasSet; 
 	} ConfigMap;
 
+	// fills in the parameters of one Config, an NVDIMM makes one of these for its own Config
+	// when it is constructed and whenever it needs to change one of its parameters
 	class Init 
 	{		
 		public:
-			static void SetKey(string key, string value, bool isSystemParam = false, size_t lineNumber = 0);
-			static void OverrideKeys(vector<string> keys, vector<string> values);
-			static void ReadIniFile(string filename, bool isSystemParam);
+			Init(Config *config);
+			void SetKey(string key, string value, bool isSystemParam = false, size_t lineNumber = 0);
+			bool HasKey(string key);
+			void OverrideKeys(vector<string> keys, vector<string> values);
+			// for a copy of a Config that other filled in, the keys other set count as set here too
+			void CopySetKeys(const Init &other);
+			void ReadIniFile(string filename, bool isSystemParam);
 			//static void InitEnumsFromStrings();
-			static bool CheckIfAllSet();
-			static void WriteValuesOut(std::ofstream &visDataOut);
+			// also works out the parameters that are derived from the ones in the ini file
+			bool CheckIfAllSet();
+			void WriteValuesOut(std::ofstream &visDataOut);
 		private:
 			static void Trim(string &str);
+
+			Config *config;
+			vector<ConfigMap> configMap;
 	};
 }
 
@@ -0,0 +1,137 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//LatencyHistogram.cpp
+//class file for a histogram of latencies
+
+#include "LatencyHistogram.h"
+#include <math.h>
+
+using namespace NVDSim;
+using namespace std;
+
+LatencyHistogram::LatencyHistogram(void)
+{
+	samples = 0;
+	largest = 0;
+}
+
+uint64_t LatencyHistogram::bucket(uint64_t cycles)
+{
+	if (cycles < 2 * LATENCY_SUB_BUCKETS)
+	{
+		return cycles;
+	}
+
+	// keep the top LATENCY_SUB_BUCKET_BITS + 1 bits of the latency, the shift says which power of two it is in
+	uint64_t shift = (63 - __builtin_clzll(cycles)) - LATENCY_SUB_BUCKET_BITS;
+	return shift * LATENCY_SUB_BUCKETS + (cycles >> shift);
+}
+
+uint64_t LatencyHistogram::bucketTop(uint64_t index)
+{
+	if (index < 2 * LATENCY_SUB_BUCKETS)
+	{
+		return index;
+	}
+
+	uint64_t shift = index / LATENCY_SUB_BUCKETS - 1;
+	uint64_t top = index % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS;
+	return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t cycles)
+{
+	uint64_t index = bucket(cycles);
+	if (index >= buckets.size())
+	{
+		buckets.resize(index + 1, 0);
+	}
+	buckets[index]++;
+	samples++;
+	if (cycles > largest)
+	{
+		largest = cycles;
+	}
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other)
+{
+	if (other.buckets.size() > buckets.size())
+	{
+		buckets.resize(other.buckets.size(), 0);
+	}
+	for (uint64_t i = 0; i < other.buckets.size(); i++)
+	{
+		buckets[i] += other.buckets[i];
+	}
+	samples += other.samples;
+	if (other.largest > largest)
+	{
+		largest = other.largest;
+	}
+}
+
+void LatencyHistogram::clear(void)
+{
+	buckets.clear();
+	samples = 0;
+	largest = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+	if (samples == 0)
+	{
+		return 0;
+	}
+
+	uint64_t rank = (uint64_t)ceil(fraction * samples);
+	if (rank == 0)
+	{
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for (uint64_t i = 0; i < buckets.size(); i++)
+	{
+		seen += buckets[i];
+		if (seen >= rank)
+		{
+			// the top of the bucket can be past the largest latency that was actually seen
+			uint64_t top = bucketTop(i);
+			return (top < largest) ? top : largest;
+		}
+	}
+	return largest;
+}
@@ -0,0 +1,73 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVLATENCYHISTOGRAM_H
+#define NVLATENCYHISTOGRAM_H
+//LatencyHistogram.h
+//header file for a histogram of latencies
+
+#include <vector>
+#include <stdint.h>
+
+namespace NVDSim{
+	// Counts latencies in log-linear buckets, every power of two is split into LATENCY_SUB_BUCKETS
+	// buckets so a percentile read back off it is within about 6% of the real latency. Latencies below
+	// 2 * LATENCY_SUB_BUCKETS cycles are counted exactly. Buckets are only allocated up to the largest
+	// latency seen so a histogram that is never used costs nothing.
+	#define LATENCY_SUB_BUCKET_BITS 4
+	#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+
+	class LatencyHistogram{
+		public:
+			LatencyHistogram(void);
+
+			void record(uint64_t cycles);
+			// adds all of the latencies in another histogram to this one
+			void add(const LatencyHistogram &other);
+			void clear(void);
+
+			uint64_t count(void) const { return samples; }
+			uint64_t max(void) const { return largest; }
+			// the latency that fraction of the samples are at or below, rounded up to the top of its bucket
+			uint64_t percentile(double fraction) const;
+
+		private:
+			static uint64_t bucket(uint64_t cycles);
+			static uint64_t bucketTop(uint64_t index);
+
+			std::vector<uint64_t> buckets;
+			uint64_t samples;
+			uint64_t largest;
+	};
+}
+#endif
@@ -0,0 +1,161 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVLOCKFREEQUEUE_H
+#define NVLOCKFREEQUEUE_H
+//LockFreeQueue.h
+//header file for a bounded queue that threads can share without locks
+
+#include <atomic>
+#include <stdint.h>
+
+namespace NVDSim{
+	// A fixed size ring that any number of threads can push to and pop from without taking a lock.
+	// Each slot has a sequence number that says whether it is waiting for a push or a pop on this lap
+	// of the ring, a thread claims a slot by moving the push or pop position along with a compare and
+	// swap and then hands the slot over by bumping its sequence number.
+	// The capacity is rounded up to a power of two.
+	template <typename T>
+	class LockFreeQueue{
+		public:
+			LockFreeQueue(uint64_t capacity)
+			{
+				uint64_t size = 1;
+				while (size < capacity)
+				{
+					size <<= 1;
+				}
+				mask = size - 1;
+				cells = new Cell[size];
+				for (uint64_t i = 0; i < size; i++)
+				{
+					cells[i].sequence.store(i, std::memory_order_relaxed);
+				}
+				push_pos.store(0, std::memory_order_relaxed);
+				pop_pos.store(0, std::memory_order_relaxed);
+			}
+
+			~LockFreeQueue(void)
+			{
+				delete [] cells;
+			}
+
+			// returns false if the queue is full
+			bool push(const T &item)
+			{
+				Cell *cell;
+				uint64_t pos = push_pos.load(std::memory_order_relaxed);
+				while (true)
+				{
+					cell = &cells[pos & mask];
+					uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+					int64_t diff = (int64_t)seq - (int64_t)pos;
+					if (diff == 0)
+					{
+						if (push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						{
+							break;
+						}
+					}
+					else if (diff < 0)
+					{
+						return false;
+					}
+					else
+					{
+						pos = push_pos.load(std::memory_order_relaxed);
+					}
+				}
+				cell->data = item;
+				cell->sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+
+			// returns false if the queue is empty
+			bool pop(T &item)
+			{
+				Cell *cell;
+				uint64_t pos = pop_pos.load(std::memory_order_relaxed);
+				while (true)
+				{
+					cell = &cells[pos & mask];
+					uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+					int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+					if (diff == 0)
+					{
+						if (pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						{
+							break;
+						}
+					}
+					else if (diff < 0)
+					{
+						return false;
+					}
+					else
+					{
+						pos = pop_pos.load(std::memory_order_relaxed);
+					}
+				}
+				item = cell->data;
+				cell->sequence.store(pos + mask + 1, std::memory_order_release);
+				return true;
+			}
+
+			uint64_t capacity(void)
+			{
+				return mask + 1;
+			}
+
+		private:
+			struct Cell
+			{
+				std::atomic<uint64_t> sequence;
+				T data;
+			};
+
+			// the queue owns the cells so it can't be copied
+			LockFreeQueue(const LockFreeQueue &);
+			LockFreeQueue &operator=(const LockFreeQueue &);
+
+			Cell *cells;
+			uint64_t mask;
+			// the pushing and popping threads each get their own cache line
+			char pad0[64];
+			std::atomic<uint64_t> push_pos;
+			char pad1[64];
+			std::atomic<uint64_t> pop_pos;
+			char pad2[64];
+	};
+}
+#endif
@@ -0,0 +1,191 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+/*LogConvert.cpp
+ *
+ * Turns the binary queue and plane state event logs (see EventLog.h) back into the text logs
+ * the simulator used to write:
+ *
+ *    ./NVDLogConvert <event log> [<event log> ...]
+ *
+ * Each <name>.bin is written out as <name>.log next to it.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include "EventLog.h"
+
+using namespace NVDSim;
+using namespace std;
+
+static bool convert(string in_name, string out_name)
+{
+	EventLogHeader header;
+	EventRecord record;
+	vector<uint32_t> plane_states;
+	uint64_t i, j, k;
+	bool in_snapshot = false;
+
+	FILE *in = fopen(in_name.c_str(), "rb");
+	if (in == NULL)
+	{
+		cerr << "ERROR: Could not open " << in_name << "\n";
+		return false;
+	}
+	if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic)) != 0)
+	{
+		cerr << "ERROR: " << in_name << " is not an event log\n";
+		fclose(in);
+		return false;
+	}
+	if (header.version != EVENT_LOG_VERSION)
+	{
+		cerr << "ERROR: " << in_name << " is event log version " << header.version << ", expected " << EVENT_LOG_VERSION << "\n";
+		fclose(in);
+		return false;
+	}
+
+	ofstream out(out_name.c_str(), ios_base::out | ios_base::trunc);
+	if (!out)
+	{
+		cerr << "ERROR: Could not open " << out_name << "\n";
+		fclose(in);
+		return false;
+	}
+
+	switch (header.kind)
+	{
+		case FTL_READ_QUEUE_EVENTS:
+			out << "FTL Read Queue Log \n";
+			break;
+		case FTL_WRITE_QUEUE_EVENTS:
+			out << "FTL Write Queue Log \n";
+			break;
+		case CTRL_READ_QUEUE_EVENTS:
+			out << "Controller Read Queue " << header.number << " Log \n";
+			break;
+		case CTRL_WRITE_QUEUE_EVENTS:
+			out << "Controller Write Queue " << header.number << " Log \n";
+			break;
+		case PLANE_STATE_EVENTS:
+			out << "Plane State Log \n";
+			plane_states = vector<uint32_t>(header.packages * header.dies * header.planes, 0);
+			break;
+		default:
+			cerr << "ERROR: " << in_name << " has an unknown kind of event log " << header.kind << "\n";
+			fclose(in);
+			return false;
+	}
+
+	while (fread(&record, sizeof(record), 1, in) == 1)
+	{
+		if (header.kind == PLANE_STATE_EVENTS)
+		{
+			if (record.queue >= plane_states.size())
+			{
+				cerr << "ERROR: " << in_name << " has a record for plane " << record.queue << " which doesn't exist\n";
+				fclose(in);
+				return false;
+			}
+			plane_states[record.queue] = record.op;
+
+			out << "Clock cycle: " << record.cycle << "\n";
+			for (i = 0; i < header.packages; i++)
+			{
+				for (j = 0; j < header.dies; j++)
+				{
+					for (k = 0; k < header.planes; k++)
+					{
+						out << plane_states[(i * header.dies + j) * header.planes + k] << " ";
+					}
+					out << "   ";
+				}
+				out << "\n";
+			}
+			out << "\n";
+		}
+		else
+		{
+			// a queue snapshot is every record up to the next EVENT_END
+			if (!in_snapshot)
+			{
+				out << "Clock cycle: " << record.cycle << "\n";
+				in_snapshot = true;
+			}
+			if (record.op == EVENT_END)
+			{
+				out << "\n";
+				in_snapshot = false;
+			}
+			else
+			{
+				out << "Address: " << record.address << ", Transaction Type: " << record.op << "\n";
+			}
+		}
+	}
+
+	fclose(in);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	string out_name;
+	int i, failed = 0;
+
+	if (argc < 2)
+	{
+		cerr << "usage: " << argv[0] << " <event log> [<event log> ...]\n";
+		return 1;
+	}
+
+	for (i = 1; i < argc; i++)
+	{
+		out_name = argv[i];
+		if (out_name.size() > 4 && out_name.compare(out_name.size() - 4, 4, ".bin") == 0)
+		{
+			out_name = out_name.substr(0, out_name.size() - 4);
+		}
+		out_name += ".log";
+
+		if (!convert(argv[i], out_name))
+		{
+			failed = 1;
+		}
+	}
+	return failed;
+}
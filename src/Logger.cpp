@@ -33,6 +33,8 @@
 
 #include "Logger.h"
 
+#include <string.h>
+
 using namespace NVDSim;
 using namespace std;
 
@@ -60,125 +62,259 @@ Logger::Logger()
 
 	max_ftl_queue_length = 0;
 	max_ctrl_queue_length = vector<uint64_t>(NUM_PACKAGES, 0);
+	ctrl_queue = vector<QueueLengthEntry>(NUM_PACKAGES);
 
-	if(PLANE_STATE_LOG)
-	{
-	    first_state_log = true;
-	
-	    plane_states = new PlaneStateType **[NUM_PACKAGES];
-	    for(uint i = 0; i < NUM_PACKAGES; i++){
-		plane_states[i] = new PlaneStateType *[DIES_PER_PACKAGE];
-		for(uint j = 0; j < DIES_PER_PACKAGE; j++){
-		    plane_states[i][j] = new PlaneStateType[PLANES_PER_DIE];
-		    for(uint k = 0; k < PLANES_PER_DIE; k++){
-			plane_states[i][j][k] = IDLE;
-		    }
-		}
-	    }
-	}
-
-	if(QUEUE_EVENT_LOG)
+	events = NULL;
+	made_log_dir = false;
+	log_dir = LOG_DIR;
+	if(QUEUE_EVENT_LOG || PLANE_STATE_LOG)
 	{
-	    first_ftl_read_log = true;
-	    first_ftl_write_log = true;
-	    first_ctrl_read_log = new bool [NUM_PACKAGES];
-	    first_crtl_write_log = new bool [NUM_PACKAGES];
-	    
-	    for(uint i = 0; i < NUM_PACKAGES; i++){
-		first_ctrl_read_log[i] = true;
-		first_crtl_write_log[i] = true;
-	    }
+	    events = new EventLog(3 + 2 * NUM_PACKAGES);
 	}
 
 	idle_energy = vector<double>(NUM_PACKAGES, 0.0); 
 	access_energy = vector<double>(NUM_PACKAGES, 0.0);        
+	idle_settled = 0;
+
+	latency_histograms = vector<LatencyHistogram>((NUM_LATENCY_KINDS + NUM_ACCESS_STAGES) * NUM_PACKAGES);
+	epoch_latency_histograms = vector<LatencyHistogram>(NUM_LATENCY_KINDS + NUM_ACCESS_STAGES);
+
+	access_table = vector<AccessMapEntry>(1024);
+	access_mask = access_table.size() - 1;
+	accesses_in_flight = 0;
+}
+
+Logger::~Logger()
+{
+	// anything still buffered in the event logs is written out before they close
+	delete events;
 }
 
 void Logger::update()
 {
-    	//update idle energy
-	//since this is already subtracted from the access energies we just do it every time
+	// the idle energy is added when it is read, see settle_idle_energy
+	this->step();
+}
+
+// accounts for a stretch of cycles where nothing happened but the packages sat idle
+void Logger::skipCycles(uint64_t cycles)
+{
+	currentClockCycle += cycles;
+}
+
+void Logger::settle_idle_energy(void)
+{
+	//update idle energy
+	//since this is already subtracted from the access energies every package gets it every cycle
+	uint64_t cycles = currentClockCycle - idle_settled;
 	for(uint i = 0; i < (NUM_PACKAGES); i++)
 	{
-	  idle_energy[i] += STANDBY_I;
+	  idle_energy[i] += STANDBY_I * cycles;
 	}
-
-	this->step();
+	idle_settled = currentClockCycle;
 }
 
-void Logger::access_start(uint64_t addr)
+void Logger::access_start(uint64_t id)
 {
-	access_queue.push_back(pair <uint64_t, uint64_t>(addr, currentClockCycle));
+	if (find_access(id) != NULL)
+	{
+		cerr << "ERROR: NVLogger.access_start() called with an id that is already in the access table. id=" << id << "\n";
+		abort();
+	}
+
+	// one access that stays in flight for a long time only pushes the accesses that land on its slot
+	// into the overflow map, the table itself only grows when it is getting full
+	if (accesses_in_flight >= access_table.size() / 2)
+	{
+		grow_access_table();
+	}
+	accesses_in_flight++;
+
+	AccessMapEntry *slot = &access_table[id & access_mask];
+	if (slot->used)
+	{
+		slot = &access_overflow[id];
+	}
+
+	AccessMapEntry &a = *slot;
+	a.start = this->currentClockCycle;
+	a.process = 0;
+	a.stop = 0;
+	a.pAddr = 0;
+	a.package = 0;
+	a.op = READ;
+	a.processing = false;
+	a.id = id;
+	a.used = true;
+	a.stage_start[FTL_QUEUE_STAGE] = a.start;
+	a.stages = 1 << FTL_QUEUE_STAGE;
 }
 
-// Using virtual addresses here right now
-void Logger::access_process(uint64_t addr, uint64_t paddr, uint package, ChannelPacketType op)
+void Logger::grow_access_table(void)
 {
-        // Get entry off of the access_queue.
-	uint64_t start_cycle = 0;
-	bool found = false;
-	list<pair <uint64_t, uint64_t>>::iterator it;
-	for (it = access_queue.begin(); it != access_queue.end(); it++)
+	vector<AccessMapEntry> old_table;
+	unordered_map<uint64_t, AccessMapEntry> old_overflow;
+	old_table.swap(access_table);
+	old_overflow.swap(access_overflow);
+	access_table = vector<AccessMapEntry>(old_table.size() * 2);
+	access_mask = access_table.size() - 1;
+
+	// the accesses from the table keep a slot to themselves since the slot only gets another bit of the id,
+	// the ones from the overflow map may still collide
+	for (uint64_t i = 0; i < old_table.size(); i++)
 	{
-		uint64_t cur_addr = (*it).first;
-		uint64_t cur_cycle = (*it).second;
-
-		if (cur_addr == addr)
+		if (old_table[i].used)
+		{
+			access_table[old_table[i].id & access_mask] = old_table[i];
+		}
+	}
+	for (unordered_map<uint64_t, AccessMapEntry>::iterator it = old_overflow.begin(); it != old_overflow.end(); it++)
+	{
+		if (access_table[it->first & access_mask].used)
 		{
-			start_cycle = cur_cycle;
-			found = true;
-			access_queue.erase(it);
-			break;
+			access_overflow[it->first] = it->second;
+		}
+		else
+		{
+			access_table[it->first & access_mask] = it->second;
 		}
 	}
+}
 
-	if (!found)
+Logger::AccessMapEntry *Logger::find_access(uint64_t id)
+{
+	AccessMapEntry &a = access_table[id & access_mask];
+	if (a.used && a.id == id)
 	{
-		cerr << "ERROR: NVLogger.access_process() called with address not in the access_queue. address=0x" << hex << addr << "\n" << dec;
-		abort();
+		return &a;
 	}
 
-	if (op == READ || op == GC_READ)
+	if (access_overflow.empty())
 	{
-	    if(access_map[addr][paddr].size() > 2)
-	    {
-		cerr << "ERROR: NVLogger.access_process() called for a read with more than one entry already in access_map. address=0x" << hex << addr << "\n" << dec;
-		abort();
-	    }
+		return NULL;
 	}
-	else
+	unordered_map<uint64_t, AccessMapEntry>::iterator it = access_overflow.find(id);
+	if (it == access_overflow.end())
 	{
-	    if(access_map[addr][paddr].size() != 0)
-	    {
-		cerr << "ERROR: NVLogger.access_process() called with address already in access_map. address=0x" << hex << addr << "\n" << dec;
+		return NULL;
+	}
+	return &it->second;
+}
+
+void Logger::access_stage(uint64_t id, AccessStage stage)
+{
+	// accesses that were never started, like fast forwarded ones, aren't followed
+	AccessMapEntry *a = find_access(id);
+	if (a != NULL && !(a->stages & (1 << stage)))
+	{
+		a->stage_start[stage] = this->currentClockCycle;
+		a->stages |= 1 << stage;
+	}
+}
+
+void Logger::access_process(uint64_t id, uint64_t paddr, uint package, ChannelPacketType op)
+{
+	AccessMapEntry *entry = find_access(id);
+	if (entry == NULL || entry->processing)
+	{
+		cerr << "ERROR: NVLogger.access_process() called with an id that isn't waiting to be processed. id=" << id << "\n";
 		abort();
-	    }
 	}
+	AccessMapEntry &a = *entry;
 
-	AccessMapEntry a;
-	a.start = start_cycle;
 	a.op = op;
 	a.process = this->currentClockCycle;
 	a.pAddr = paddr;
 	a.package = package;
-	//access_map[addr] = std::unordered_map<uint64_t, AccessMapEntry>();
-	access_map[addr][paddr].push_back(a);
-	//cout << "access map now has size " << access_map[addr][paddr].size() << "\n";
+	a.processing = true;
 	
 	this->queue_latency(a.process - a.start);
 }
 
-void Logger::access_stop(uint64_t addr, uint64_t paddr)
+Logger::AccessMapEntry &Logger::stop_entry(uint64_t id, const char *logger)
 {
-        if (access_map[addr][paddr].empty())
+	AccessMapEntry *entry = find_access(id);
+	if (entry == NULL || !entry->processing)
 	{
-		cerr << "ERROR: NVLogger.access_stop() called with address not in access_map. address=" << hex << addr << "\n" << dec;
+		cerr << "ERROR: " << logger << ".access_stop() called with an id that isn't being processed. id=" << id << "\n";
 		abort();
 	}
-
-	AccessMapEntry a = access_map[addr][paddr].front();
+	AccessMapEntry &a = *entry;
 	a.stop = this->currentClockCycle;
-	access_map[addr][paddr].front() = a;
+	return a;
+}
+
+void Logger::record_latency(const AccessMapEntry &a)
+{
+	LatencyKind kind, queue_kind = QUEUE_LATENCY;
+	switch (a.op)
+	{
+	case READ:
+		kind = READ_LATENCY;
+		break;
+	case WRITE:
+		kind = WRITE_LATENCY;
+		break;
+	case GC_READ:
+		kind = GC_READ_LATENCY;
+		queue_kind = GC_QUEUE_LATENCY;
+		break;
+	case GC_WRITE:
+		kind = GC_WRITE_LATENCY;
+		queue_kind = GC_QUEUE_LATENCY;
+		break;
+	case ERASE:
+		kind = ERASE_LATENCY;
+		queue_kind = GC_QUEUE_LATENCY;
+		break;
+	default:
+		return;
+	}
+
+	latency_histograms[kind * NUM_PACKAGES + a.package].record(a.stop - a.start);
+	latency_histograms[queue_kind * NUM_PACKAGES + a.package].record(a.process - a.start);
+	epoch_latency_histograms[kind].record(a.stop - a.start);
+	epoch_latency_histograms[queue_kind].record(a.process - a.start);
+
+	if (a.op == READ || a.op == WRITE)
+	{
+		record_stages(a);
+	}
+}
+
+void Logger::record_stages(const AccessMapEntry &a)
+{
+	uint last = FTL_QUEUE_STAGE;
+	for (uint s = FTL_QUEUE_STAGE + 1; s <= NUM_ACCESS_STAGES; s++)
+	{
+		if (s == NUM_ACCESS_STAGES || (a.stages & (1 << s)))
+		{
+			// the last stage it got to ends when the access does
+			uint64_t end = (s == NUM_ACCESS_STAGES) ? a.stop : a.stage_start[s];
+			latency_histograms[(NUM_LATENCY_KINDS + last) * NUM_PACKAGES + a.package].record(end - a.stage_start[last]);
+			epoch_latency_histograms[NUM_LATENCY_KINDS + last].record(end - a.stage_start[last]);
+			last = s;
+		}
+	}
+}
+
+void Logger::end_access(AccessMapEntry &a)
+{
+	accesses_in_flight--;
+	if (&a == &access_table[a.id & access_mask])
+	{
+		a.used = false;
+	}
+	else
+	{
+		uint64_t id = a.id;
+		access_overflow.erase(id);
+	}
+}
+
+void Logger::access_stop(uint64_t id)
+{
+	AccessMapEntry &a = stop_entry(id, "NVLogger");
 
 	// Log cache event type.
 	if (a.op == READ)
@@ -206,171 +342,105 @@ void Logger::access_stop(uint64_t addr, uint64_t paddr)
 		}
 	    }
 	}
-	
-	access_map[addr][paddr].pop_front();
-	if(access_map[addr][paddr].empty())
-	{
-	    access_map[addr].erase(paddr);
-	    if(access_map.count(addr) == 0)
-	    {
-		access_map.erase(addr);
-	    }
-	}
+
+	record_latency(a);
+	end_access(a);
 }
 
 void Logger::log_ftl_queue_event(bool write, std::list<FlashTransaction> *queue)
 {
-    if(!write)
-    {
-	if(first_ftl_read_log == true)
-	{
-	    string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
-	    const char * command = command_str.c_str();
-	    int sys_done = system(command);
-	    if (sys_done != 0)
-	    {
-		WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
-	    }
-	    savefile.open(LOG_DIR+"FtlReadQueue.log", ios_base::out | ios_base::trunc);
-	    savefile<<"FTL Read Queue Log \n";
-	    first_ftl_read_log = false;
-	}
-	else
-	{
-	    savefile.open(LOG_DIR+"FtlReadQueue.log", ios_base::out | ios_base::app);
-	}
-    }
-    else if(write)
+    uint log = write ? 1 : 0;
+    if(!events->isOpen(log))
     {
-	if(first_ftl_write_log == true)
+	if(!write)
 	{
-	    string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
-	    const char * command = command_str.c_str();
-	    int sys_done = system(command);
-	    if (sys_done != 0)
-	    {
-		WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
-	    }
-	    savefile.open(LOG_DIR+"FtlWriteQueue.log", ios_base::out | ios_base::trunc);
-	    savefile<<"FTL Write Queue Log \n";
-	    first_ftl_write_log = false;
+	    open_event_log(log, "FtlReadQueue.bin", FTL_READ_QUEUE_EVENTS, 0);
 	}
 	else
 	{
-	    savefile.open(LOG_DIR+"FtlWriteQueue.log", ios_base::out | ios_base::app);
+	    open_event_log(log, "FtlWriteQueue.bin", FTL_WRITE_QUEUE_EVENTS, 0);
 	}
     }
 
-    savefile<<"Clock cycle: "<<currentClockCycle<<"\n";
     std::list<FlashTransaction>::iterator it;
     for (it = queue->begin(); it != queue->end(); it++)
     {
-	savefile<<"Address: "<<(*it).address<<", Transaction Type: "<<(*it).transactionType<<"\n";
+	events->record(log, currentClockCycle, 0, (*it).transactionType, (*it).address);
     }
-    savefile<<"\n";
-    
-    savefile.close();
+    events->record(log, currentClockCycle, 0, EVENT_END, 0);
 }
 
 void Logger::log_ctrl_queue_event(bool write, uint64_t number, std::list<ChannelPacket*> *queue)
 {
-    if(!write)
-    {					       
-	std::string file = "CtrlReadQueue";
-        std::stringstream temp;
-	temp << number;
-	file += temp.str();
-        file += ".log";
-	if(first_ctrl_read_log[number] == true)
-	{
-	    string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
-	    const char * command = command_str.c_str();
-	    int sys_done = system(command);
-	    if (sys_done != 0)
-	    {
-		WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
-	    }
-	    savefile.open(LOG_DIR+file, ios_base::out | ios_base::trunc);
-	    savefile<<"Controller Read Queue " << number << " Log \n";
-	    first_ctrl_read_log[number] = false;
-	}
-	else
-	{
-	    savefile.open(LOG_DIR+file, ios_base::out | ios_base::app);
-	}
-    }
-    else if(write)
+    uint log = 3 + 2 * number + (write ? 1 : 0);
+    if(!events->isOpen(log))
     {
-	std::string file = "CtrlWriteQueue";
+	std::string file = write ? "CtrlWriteQueue" : "CtrlReadQueue";
 	std::stringstream temp;
 	temp << number;
 	file += temp.str();
-	file += ".log";
-	if(first_crtl_write_log[number] == true)
-	{
-	    string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
-	    const char * command = command_str.c_str();
-	    int sys_done = system(command);
-	    if (sys_done != 0)
-	    {
-		WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
-	    }
-	    savefile.open(LOG_DIR+file, ios_base::out | ios_base::trunc);
-	    savefile<<"Controller Write Queue " << number << " Log \n";
-	    first_crtl_write_log[number] = false;
-	}
-	else
-	{
-	    savefile.open(LOG_DIR+file, ios_base::out | ios_base::app);
-	}
+	file += ".bin";
+	open_event_log(log, file, write ? CTRL_WRITE_QUEUE_EVENTS : CTRL_READ_QUEUE_EVENTS, number);
     }
 
-    savefile<<"Clock cycle: "<<currentClockCycle<<"\n";
     std::list<ChannelPacket*>::iterator it;
     for (it = queue->begin(); it != queue->end(); it++)
     {
-	savefile<<"Address: "<<(*it)->virtualAddress<<", Transaction Type: "<<(*it)->busPacketType<<"\n";
+	events->record(log, currentClockCycle, number, (*it)->busPacketType, (*it)->virtualAddress);
     }
-    savefile<<"\n";
-    
-    savefile.close();
+    events->record(log, currentClockCycle, number, EVENT_END, 0);
 }
 
 void Logger::log_plane_state(uint64_t package, uint64_t die, uint64_t plane, PlaneStateType op)
 {
-    plane_states[package][die][plane] = op;
-    
-    if(first_state_log == 0)
+    if(!events->isOpen(2))
+    {
+	open_event_log(2, "PlaneState.bin", PLANE_STATE_EVENTS, 0);
+    }
+
+    events->record(2, currentClockCycle, (package * DIES_PER_PACKAGE + die) * PLANES_PER_DIE + plane, op, 0);
+}
+
+void Logger::open_event_log(uint log, std::string file, EventLogKind kind, uint64_t number)
+{
+    if(!made_log_dir)
     {
-	string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
+	string command_str = "test -e "+log_dir+" || mkdir "+log_dir;
 	const char * command = command_str.c_str();
 	int sys_done = system(command);
 	if (sys_done != 0)
 	{
 	    WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
 	}
-	savefile.open(LOG_DIR+"PlaneState.log", ios_base::out | ios_base::trunc);
-	savefile<<"Plane State Log \n";
-	first_state_log = 1;
-    }
-    else
-    {
-	savefile.open(LOG_DIR+"PlaneState.log", ios_base::out | ios_base::app);
+	made_log_dir = true;
     }
 
-    savefile<<"Clock cycle: "<<currentClockCycle<<"\n";
-    for(uint i = 0; i < NUM_PACKAGES; i++){
-	for(uint j = 0; j < DIES_PER_PACKAGE; j++){
-	    for(uint k = 0; k < PLANES_PER_DIE; k++){
-		savefile<<plane_states[i][j][k]<<" ";
-	    }
-	    savefile<<"   ";
-	}
-	savefile<<"\n";
+    EventLogHeader header;
+    memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic));
+    header.version = EVENT_LOG_VERSION;
+    header.kind = kind;
+    header.number = number;
+    header.packages = NUM_PACKAGES;
+    header.dies = DIES_PER_PACKAGE;
+    header.planes = PLANES_PER_DIE;
+
+    events->open(log, log_dir+file, header);
+}
+
+void Logger::closeEventLogs(void)
+{
+    if(events != NULL)
+    {
+	events->close();
     }
-    savefile<<"\n";
+    // log_dir might be different by the time they are opened again
+    made_log_dir = false;
+}
 
-    savefile.close();
+void Logger::setLogDir(std::string dir)
+{
+    log_dir = dir;
+    made_log_dir = false;
 }
 
 void Logger::read()
@@ -473,58 +543,132 @@ double Logger::divide(double num, double denom)
     }
 }
 
-void Logger::ftlQueueLength(uint64_t length)
+void Logger::take_epoch_latencies(vector<LatencyHistogram> &out)
 {
-    if(length > ftl_queue_length){
-	ftl_queue_length = length;
-    }
-
-    if(length > max_ftl_queue_length){
-	max_ftl_queue_length = length;
+    out = epoch_latency_histograms;
+    for(uint i = 0; i < epoch_latency_histograms.size(); i++)
+    {
+	epoch_latency_histograms[i].clear();
     }
 }
 
-void Logger::ftlQueueLength(uint64_t length, uint64_t length2)
+void Logger::write_latency_percentiles(const vector<LatencyHistogram> &histograms, uint packages)
 {
-    if(length > ftl_queue_length){
-	ftl_queue_length = length;
-    }
+    static const char *names[NUM_LATENCY_KINDS + NUM_ACCESS_STAGES] = {"Read", "Write", "Queue", "Garbage Collector initiated Read", "Garbage Collector initiated Write", "Erase", "Garbage Collector Queue",
+								      "Ftl Queue", "Ftl Lookup", "Controller Queue", "Channel", "Die", "Return"};
 
-    if(length > max_ftl_queue_length){
-	max_ftl_queue_length = length;
-    }
+    savefile<<"\nLatency Percentiles: \n";
+    savefile<<"========================\n";
+    write_percentiles(histograms, packages, 0, NUM_LATENCY_KINDS, names);
+
+    savefile<<"\nTime in Each Stage for Host Accesses: \n";
+    savefile<<"========================\n";
+    write_percentiles(histograms, packages, NUM_LATENCY_KINDS, NUM_LATENCY_KINDS + NUM_ACCESS_STAGES, names);
 }
 
-void Logger::ctrlQueueLength(vector<uint64_t> length)
+void Logger::write_percentiles(const vector<LatencyHistogram> &histograms, uint packages, uint first, uint last, const char *const *names)
 {
-    for(uint i = 0; i < length.size(); i++)
+    for(uint k = first; k < last; k++)
     {
-	if(length[i] > ctrl_queue_length[i])
+	LatencyHistogram total;
+	for(uint i = 0; i < packages; i++)
 	{
-	    ctrl_queue_length[i] = length[i];
+	    total.add(histograms[k * packages + i]);
 	}
-	if(length[i] > max_ctrl_queue_length[i])
+	if(total.count() == 0)
 	{
-	    max_ctrl_queue_length[i] = length[i];
+	    continue;
+	}
+
+	for(uint i = 0; i <= packages; i++)
+	{
+	    const LatencyHistogram *h;
+	    if(i == 0)
+	    {
+		h = &total;
+		savefile<<names[k]<<((k < NUM_LATENCY_KINDS) ? " Latency: " : ": ");
+	    }
+	    else if(packages > 1)
+	    {
+		h = &histograms[k * packages + i - 1];
+		savefile<<"    Package "<<(i - 1)<<": ";
+	    }
+	    else
+	    {
+		break;
+	    }
+	    savefile<<h->count()<<" accesses, p50 "<<h->percentile(0.5)<<", p90 "<<h->percentile(0.9)<<", p99 "<<h->percentile(0.99);
+	    savefile<<", p99.9 "<<h->percentile(0.999)<<", max "<<h->max()<<" cycles\n";
 	}
     }
 }
 
+void Logger::settle_queue(QueueLengthEntry &q, uint64_t &epoch_max, uint64_t &max)
+{
+    if(currentClockCycle > q.since)
+    {
+	if(q.length > epoch_max){
+	    epoch_max = q.length;
+	}
+
+	if(q.length > max){
+	    max = q.length;
+	}
+
+	q.integral += q.length * (currentClockCycle - q.since);
+	q.epoch_integral += q.length * (currentClockCycle - q.since);
+	q.since = currentClockCycle;
+    }
+}
+
+void Logger::settle_queue_lengths(void)
+{
+    settle_queue(ftl_queue, ftl_queue_length, max_ftl_queue_length);
+    for(uint i = 0; i < ctrl_queue.size(); i++)
+    {
+	settle_queue(ctrl_queue[i], ctrl_queue_length[i], max_ctrl_queue_length[i]);
+    }
+}
+
+void Logger::ftlQueueLength(uint64_t length)
+{
+    settle_queue(ftl_queue, ftl_queue_length, max_ftl_queue_length);
+    ftl_queue.length = length;
+}
+
+void Logger::ftlQueueLength(uint64_t length, uint64_t length2)
+{
+    ftlQueueLength(length);
+}
+
+void Logger::ctrlQueueLength(uint64_t package, uint64_t length)
+{
+    settle_queue(ctrl_queue[package], ctrl_queue_length[package], max_ctrl_queue_length[package]);
+    ctrl_queue[package].length = length;
+}
+
 void Logger::ftlQueueReset()
 {
+    settle_queue(ftl_queue, ftl_queue_length, max_ftl_queue_length);
     ftl_queue_length = 0;
+    ftl_queue.epoch_integral = 0;
 }
 
 void Logger::ctrlQueueReset()
 {
     for(uint i = 0; i < ctrl_queue_length.size(); i++)
     {
+	settle_queue(ctrl_queue[i], ctrl_queue_length[i], max_ctrl_queue_length[i]);
 	ctrl_queue_length[i] = 0;
+	ctrl_queue[i].epoch_integral = 0;
     }
 }
 
 void Logger::save(uint64_t cycle, uint epoch) 
 {
+	settle_idle_energy();
+	settle_queue_lengths();
+
         // Power stuff
 	// Total power used
 	vector<double> total_energy = vector<double>(NUM_PACKAGES, 0.0);
@@ -552,14 +696,14 @@ void Logger::save(uint64_t cycle, uint epoch)
 	    }
 	}
 
-	string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
+	string command_str = "test -e "+log_dir+" || mkdir "+log_dir;
 	const char * command = command_str.c_str();
 	int sys_done = system(command);
 	if (sys_done != 0)
 	{
 	    WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
 	}
-	savefile.open(LOG_DIR+"NVDIMM.log", ios_base::out | ios_base::trunc);
+	savefile.open(log_dir+"NVDIMM.log", ios_base::out | ios_base::trunc);
 	savefile<<"NVDIMM Log \n";
 
 	if (!savefile) 
@@ -598,12 +742,16 @@ void Logger::save(uint64_t cycle, uint epoch)
 	savefile<<"Read Throughput: " <<this->calc_throughput(cycle, num_reads)<<" KB/sec\n";
 	savefile<<"Write Throughput: " <<this->calc_throughput(cycle, num_writes)<<" KB/sec\n";
 
+	write_latency_percentiles(latency_histograms, NUM_PACKAGES);
+
 	savefile<<"\nQueue Length Data: \n";
 	savefile<<"========================\n";
 	savefile<<"Maximum Length of Ftl Queue: " <<max_ftl_queue_length<<"\n";
+	savefile<<"Average Length of Ftl Queue: " <<divide((double)ftl_queue.integral, (double)cycle)<<"\n";
 	for(uint i = 0; i < max_ctrl_queue_length.size(); i++)
 	{
 	    savefile<<"Maximum Length of Controller Queue for Package " << i << ": "<<max_ctrl_queue_length[i]<<"\n";
+	    savefile<<"Average Length of Controller Queue for Package " << i << ": "<<divide((double)ctrl_queue[i].integral, (double)cycle)<<"\n";
 	}
 
 	if(WEAR_LEVEL_LOG)
@@ -648,6 +796,8 @@ void Logger::save(uint64_t cycle, uint epoch)
 
 void Logger::print(uint64_t cycle) 
 {
+	settle_idle_energy();
+
         // Power stuff
 	// Total power used
 	vector<double> total_energy = vector<double>(NUM_PACKAGES, 0.0);
@@ -686,6 +836,8 @@ void Logger::print(uint64_t cycle)
 
 vector<vector<double> > Logger::getEnergyData(void)
 {
+    settle_idle_energy();
+
     vector<vector<double> > temp = vector<vector<double> >(2, vector<double>(NUM_PACKAGES, 0.0));
     for(uint i = 0; i < NUM_PACKAGES; i++)
     {
@@ -695,8 +847,26 @@ vector<vector<double> > Logger::getEnergyData(void)
     return temp;
 }
 
+const vector<double> *Logger::getEnergyField(PowerField field)
+{
+    settle_idle_energy();
+
+    switch (field)
+    {
+    case IDLE_ENERGY:
+	return &idle_energy;
+    case ACCESS_ENERGY:
+	return &access_energy;
+    default:
+	return NULL;
+    }
+}
+
 void Logger::save_epoch(uint64_t cycle, uint epoch)
 {
+    settle_idle_energy();
+    settle_queue_lengths();
+
     EpochEntry this_epoch;
     this_epoch.cycle = cycle;
     this_epoch.epoch = epoch;
@@ -719,12 +889,14 @@ void Logger::save_epoch(uint64_t cycle, uint epoch)
     this_epoch.average_queue_latency = average_queue_latency;
 
     this_epoch.ftl_queue_length = ftl_queue_length;
+    this_epoch.ftl_queue_integral = ftl_queue.epoch_integral;
 
     this_epoch.writes_per_address = writes_per_address;
 
     for(uint i = 0; i < ctrl_queue_length.size(); i++)
     {
 	this_epoch.ctrl_queue_length[i] = ctrl_queue_length[i];
+	this_epoch.ctrl_queue_integral[i] = ctrl_queue[i].epoch_integral;
     }
 
     for(uint i = 0; i < NUM_PACKAGES; i++)
@@ -733,6 +905,8 @@ void Logger::save_epoch(uint64_t cycle, uint epoch)
 	this_epoch.access_energy[i] = access_energy[i]; 
     }
 
+    take_epoch_latencies(this_epoch.latency_histograms);
+
     EpochEntry temp_epoch;
 
     temp_epoch = this_epoch;
@@ -781,19 +955,19 @@ void Logger::write_epoch(EpochEntry *e)
 {
     	if(e->epoch == 0 && RUNTIME_WRITE)
 	{
-	    string command_str = "test -e "+LOG_DIR+" || mkdir "+LOG_DIR;
+	    string command_str = "test -e "+log_dir+" || mkdir "+log_dir;
 	    const char * command = command_str.c_str();
 	    int sys_done = system(command);
 	    if (sys_done != 0)
 	    {
 		WARNING("Something might have gone wrong when nvdimm attempted to makes its log directory");
 	    }
-	    savefile.open(LOG_DIR+"NVDIMM_EPOCH.log", ios_base::out | ios_base::trunc);
+	    savefile.open(log_dir+"NVDIMM_EPOCH.log", ios_base::out | ios_base::trunc);
 	    savefile<<"NVDIMM_EPOCH Log \n";
 	}
 	else
 	{
-	    savefile.open(LOG_DIR+"NVDIMM_EPOCH.log", ios_base::out | ios_base::app);
+	    savefile.open(log_dir+"NVDIMM_EPOCH.log", ios_base::out | ios_base::app);
 	}
 
 	if (!savefile) 
@@ -856,12 +1030,16 @@ void Logger::write_epoch(EpochEntry *e)
 	savefile<<"Read Throughput: " <<this->calc_throughput(e->cycle, e->num_reads)<<" KB/sec\n";
 	savefile<<"Write Throughput: " <<this->calc_throughput(e->cycle, e->num_writes)<<" KB/sec\n";
 
+	write_latency_percentiles(e->latency_histograms, 1);
+
 	savefile<<"\nQueue Length Data: \n";
 	savefile<<"========================\n";
 	savefile<<"Length of Ftl Queue: " <<e->ftl_queue_length<<"\n";
+	savefile<<"Average Length of Ftl Queue: " <<divide((double)e->ftl_queue_integral, (double)e->cycle)<<"\n";
 	for(uint i = 0; i < e->ctrl_queue_length.size(); i++)
 	{
 	    savefile<<"Length of Controller Queue for Package " << i << ": "<<e->ctrl_queue_length[i]<<"\n";
+	    savefile<<"Average Length of Controller Queue for Package " << i << ": "<<divide((double)e->ctrl_queue_integral[i], (double)e->cycle)<<"\n";
 	}
 
 	if(WEAR_LEVEL_LOG)
@@ -45,7 +45,10 @@
 #include "SimObj.h"
 #include "FlashConfiguration.h"
 #include "ChannelPacket.h"
+#include "HostInterface.h"
 #include "FlashTransaction.h"
+#include "EventLog.h"
+#include "LatencyHistogram.h"
 
 namespace NVDSim
 {
@@ -58,15 +61,45 @@ namespace NVDSim
 	ERASING
     };
     
+    // the kinds of latency that get a histogram, the GC ones are only seen by the GC loggers
+    enum LatencyKind{
+	READ_LATENCY,
+	WRITE_LATENCY,
+	QUEUE_LATENCY,
+	GC_READ_LATENCY,
+	GC_WRITE_LATENCY,
+	ERASE_LATENCY,
+	GC_QUEUE_LATENCY,
+	NUM_LATENCY_KINDS
+    };
+
+    // the points a host request passes on its way through the device, it is in a stage from the cycle it
+    // gets to that point until it gets to the next one it passes, a stage it skips counts as part of the one before
+    enum AccessStage{
+	FTL_QUEUE_STAGE, // from access_start until an ftl lookup engine takes it
+	LOOKUP_STAGE, // until it gets to the controller queue
+	CTRL_QUEUE_STAGE, // until the controller gets the channel for it
+	CHANNEL_STAGE, // going over the channel, and through the buffer if there is one, until the die starts on it
+	DIE_STAGE, // until the die is done with it
+	RETURN_STAGE, // read data going back to the controller
+	NUM_ACCESS_STAGES
+    };
+
     class Logger: public SimObj
     {
     public:
 	Logger();
+	~Logger();
 
 	// extended logging options
 	void log_ftl_queue_event(bool write, std::list<FlashTransaction> *queue);
 	void log_ctrl_queue_event(bool write, uint64_t number, std::list<ChannelPacket*> *queue);
 	void log_plane_state(uint64_t package, uint64_t die, uint64_t plane, PlaneStateType op);
+	void open_event_log(uint log, std::string file, EventLogKind kind, uint64_t number);
+	// writes out everything in the queue and plane state logs and closes their files
+	void closeEventLogs(void);
+	// the logs opened after this go in dir instead
+	void setLogDir(std::string dir);
 	
 	// operations
 	void read();
@@ -92,7 +125,7 @@ namespace NVDSim
 
 	void ftlQueueLength(uint64_t length);
 	virtual void ftlQueueLength(uint64_t length, uint64_t length2);
-	void ctrlQueueLength(std::vector<uint64_t> length);
+	void ctrlQueueLength(uint64_t package, uint64_t length);
 
 	virtual void ftlQueueReset();
 	void ctrlQueueReset();
@@ -100,15 +133,23 @@ namespace NVDSim
 	//Accessor for power data
 	//Writing correct object oriented code up in this piece, what now?
 	virtual std::vector<std::vector<double>> getEnergyData(void);
+	// one column of the energy data without the copy, NULL if this logger doesn't keep it
+	virtual const std::vector<double> *getEnergyField(PowerField field);
 	
 	virtual void save(uint64_t cycle, uint epoch);
 	virtual void print(uint64_t cycle);
 
 	virtual void update();
+	virtual void skipCycles(uint64_t cycles);
+	// adds the standby current for the cycles since the idle energy was last brought up to date
+	virtual void settle_idle_energy(void);
 	
-	void access_start(uint64_t addr);
-	void access_process(uint64_t addr, uint64_t paddr, uint package, ChannelPacketType op);
-	virtual void access_stop(uint64_t addr, uint64_t paddr);
+	// each access is tracked by the id of its request
+	void access_start(uint64_t id);
+	void access_process(uint64_t id, uint64_t paddr, uint package, ChannelPacketType op);
+	virtual void access_stop(uint64_t id);
+	// marks the cycle an access gets to a stage, only the first time counts since a write's data goes ahead of its command
+	void access_stage(uint64_t id, AccessStage stage);
 
 	virtual void save_epoch(uint64_t cycle, uint epoch);
 	
@@ -138,20 +179,59 @@ namespace NVDSim
 	uint64_t max_ftl_queue_length;
 	std::vector<uint64_t> max_ctrl_queue_length;
 
+	// The queues send their length when it changes instead of every cycle. A cycle ends with a queue at the
+	// last length it sent, so the maximums and the integral are only brought up to date when it changes again or they are read.
+	class QueueLengthEntry
+	{
+	public:
+	    uint64_t length; // length the queue is at now
+	    uint64_t since; // first cycle at this length that hasn't been counted
+	    uint64_t integral; // sum of the length at the end of every cycle counted
+	    uint64_t epoch_integral; // the same since the last epoch
+	    QueueLengthEntry()
+	    {
+		length = 0;
+		since = 0;
+		integral = 0;
+		epoch_integral = 0;
+	    }
+	};
+
+	QueueLengthEntry ftl_queue;
+	std::vector<QueueLengthEntry> ctrl_queue;
+
+	// counts the cycles before this one at the length the queue is at
+	void settle_queue(QueueLengthEntry &q, uint64_t &epoch_max, uint64_t &max);
+	virtual void settle_queue_lengths(void);
+
 	std::unordered_map<uint64_t, uint64_t> writes_per_address;
 
+	// Latency distributions
+	// one histogram per kind of latency per package, kind * NUM_PACKAGES + package
+	// the time host accesses spend in each stage comes after the kinds of latency, as kind NUM_LATENCY_KINDS + stage
+	std::vector<LatencyHistogram> latency_histograms;
+	// one histogram per kind of latency and per stage for everything since the last epoch
+	std::vector<LatencyHistogram> epoch_latency_histograms;
+
+	// hands the latencies since the last epoch to an epoch entry and starts collecting the next epoch
+	void take_epoch_latencies(std::vector<LatencyHistogram> &out);
+	// writes the percentiles of every kind of latency and every stage that was seen to the savefile, with a line for each package after the total if there is more than one
+	void write_latency_percentiles(const std::vector<LatencyHistogram> &histograms, uint packages);
+	void write_percentiles(const std::vector<LatencyHistogram> &histograms, uint packages, uint first, uint last, const char *const *names);
+
 	// Extended logging state
-	bool first_ftl_read_log;
-	bool first_ftl_write_log;
-	bool* first_ctrl_read_log;
-	bool* first_crtl_write_log;
-	bool first_state_log;
-	PlaneStateType*** plane_states;
+	// the ftl queues are logs 0 and 1, the plane states are log 2 and each controller queue pair comes after that
+	EventLog *events;
+	bool made_log_dir;
+	// starts out as LOG_DIR, see NVDIMM::tagOutputFiles
+	std::string log_dir;
 
 	// Power Stuff
 	// This is computed per package
 	std::vector<double> idle_energy;
 	std::vector<double> access_energy;
+	// the cycles up to this one are in idle_energy
+	uint64_t idle_settled;
 
 
 	class AccessMapEntry
@@ -163,6 +243,11 @@ namespace NVDSim
 		uint64_t pAddr; // Virtual address of access
 		uint64_t package; // package for the power calculations
 		ChannelPacketType op; // what operation is this?
+		bool processing; // has access_process been called yet?
+		uint64_t id; // request id of the access in this slot
+		bool used; // is an access in this slot?
+		uint64_t stage_start[NUM_ACCESS_STAGES]; // cycle the access got to each stage
+		uint stages; // bit mask of the stages it has got to
 		AccessMapEntry()
 		{
 			start = 0;
@@ -171,19 +256,39 @@ namespace NVDSim
 			pAddr = 0;
 			package = 0;
 			op = READ;
+			processing = false;
+			id = 0;
+			used = false;
+			stages = 0;
 		}
 	};
 
-	// Store access info while the access is being processed.
-	std::unordered_map<uint64_t, std::unordered_map<uint64_t, std::list<AccessMapEntry>>> access_map;
-
-	// Store the address and arrival time while access is waiting to be processed.
-	// Must do this because duplicate addresses may arrive close together.
-	std::list<std::pair <uint64_t, uint64_t>> access_queue;
+	// Store access info from the time the access arrives until it is done.
+	// Request ids are handed out in order so each access gets the slot picked by the low bits of its id.
+	// An access whose slot is still held by an older one that is in flight goes in access_overflow and the
+	// table is only doubled once half of it is in use.
+	std::vector<AccessMapEntry> access_table;
+	uint64_t access_mask;
+	std::unordered_map<uint64_t, AccessMapEntry> access_overflow;
+	uint64_t accesses_in_flight;
+
+	void grow_access_table(void);
+	// the entry for an access in flight, NULL if there isn't one
+	AccessMapEntry *find_access(uint64_t id);
+	// the entry for an access that access_stop has been called on, aborts if there isn't one
+	AccessMapEntry &stop_entry(uint64_t id, const char *logger);
+	// adds the latency and the queue latency of a finished access to the histograms
+	void record_latency(const AccessMapEntry &a);
+	void record_stages(const AccessMapEntry &a);
+	// frees the entry once access_stop is done with it
+	void end_access(AccessMapEntry &a);
 
 	class EpochEntry
 	{
 	public:
+	    // not a SimObj itself, so this hides the logger's config_params() and sizes the entry from the current Config
+	    static const Config *config_params(void) { return NVDSim::config_params(); }
+
 	    uint64_t cycle;
 	    uint64_t epoch;
 
@@ -206,12 +311,16 @@ namespace NVDSim
 
 	    uint64_t ftl_queue_length;
 	    std::vector<uint64_t> ctrl_queue_length;
+	    uint64_t ftl_queue_integral;
+	    std::vector<uint64_t> ctrl_queue_integral;
 	    
 	    std::unordered_map<uint64_t, uint64_t> writes_per_address;
 
 	    std::vector<double> idle_energy;
 	    std::vector<double> access_energy;
 
+	    std::vector<LatencyHistogram> latency_histograms;
+
 	    EpochEntry()
 	    {
 		cycle = 0;
@@ -236,6 +345,8 @@ namespace NVDSim
 		
 		ftl_queue_length = 0;
 		ctrl_queue_length = std::vector<uint64_t>(NUM_PACKAGES, 0);
+		ftl_queue_integral = 0;
+		ctrl_queue_integral = std::vector<uint64_t>(NUM_PACKAGES, 0);
 	
 		idle_energy = std::vector<double>(NUM_PACKAGES, 0.0); 
 		access_energy = std::vector<double>(NUM_PACKAGES, 0.0);
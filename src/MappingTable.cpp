@@ -0,0 +1,130 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//MappingTable.cpp
+//class file for the ftl's virtual to physical address map
+//
+#include "MappingTable.h"
+#include <string.h>
+
+using namespace NVDSim;
+using namespace std;
+
+MappingTable::MappingTable(void){
+	// NV_PAGE_SIZE and the sizes built from it are in KB, the virtual addresses are in bytes
+	page_bytes = NV_PAGE_SIZE * 1024;
+	num_pages = VIRTUAL_TOTAL_SIZE / NV_PAGE_SIZE;
+	mapped = 0;
+
+	// the largest physical page number is reserved to mark unmapped pages
+	narrow = (TOTAL_SIZE / NV_PAGE_SIZE) < (uint64_t) NARROW_UNMAPPED;
+	if (narrow)
+		narrow_entries = vector<uint32_t>(num_pages, NARROW_UNMAPPED);
+	else
+		wide_entries = vector<uint64_t>(num_pages, NO_MAPPING);
+}
+
+uint64_t MappingTable::lookup(uint64_t vAddr){
+	uint64_t page = vAddr / page_bytes;
+
+	if (vAddr % page_bytes != 0 || page >= num_pages)
+	{
+		unordered_map<uint64_t, uint64_t>::iterator it = unaligned.find(vAddr);
+		if (it == unaligned.end())
+			return NO_MAPPING;
+		return (*it).second;
+	}
+
+	if (narrow)
+	{
+		if (narrow_entries[page] == NARROW_UNMAPPED)
+			return NO_MAPPING;
+		return narrow_entries[page] * NV_PAGE_SIZE;
+	}
+
+	if (wide_entries[page] == NO_MAPPING)
+		return NO_MAPPING;
+	return wide_entries[page] * NV_PAGE_SIZE;
+}
+
+void MappingTable::map(uint64_t vAddr, uint64_t pAddr){
+	uint64_t page = vAddr / page_bytes;
+
+	if (vAddr % page_bytes != 0 || page >= num_pages || pAddr % NV_PAGE_SIZE != 0)
+	{
+		if (unaligned.find(vAddr) == unaligned.end())
+			mapped++;
+		unaligned[vAddr] = pAddr;
+		return;
+	}
+
+	if (narrow)
+	{
+		if (narrow_entries[page] == NARROW_UNMAPPED)
+			mapped++;
+		narrow_entries[page] = (uint32_t) (pAddr / NV_PAGE_SIZE);
+	}
+	else
+	{
+		if (wide_entries[page] == NO_MAPPING)
+			mapped++;
+		wide_entries[page] = pAddr / NV_PAGE_SIZE;
+	}
+}
+
+uint64_t MappingTable::size(void){
+	return mapped;
+}
+
+void MappingTable::load(const void *entries, const uint64_t *pairs, uint64_t count){
+	uint64_t i;
+
+	mapped = 0;
+	if (narrow)
+	{
+		memcpy(narrow_entries.data(), entries, num_pages * sizeof(uint32_t));
+		for (i = 0; i < num_pages; i++)
+			mapped += (narrow_entries[i] != NARROW_UNMAPPED);
+	}
+	else
+	{
+		memcpy(wide_entries.data(), entries, num_pages * sizeof(uint64_t));
+		for (i = 0; i < num_pages; i++)
+			mapped += (wide_entries[i] != NO_MAPPING);
+	}
+
+	unaligned.clear();
+	for (i = 0; i < count; i++)
+		unaligned[pairs[2 * i]] = pairs[2 * i + 1];
+	mapped += unaligned.size();
+}
@@ -0,0 +1,99 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVMAPPINGTABLE_H
+#define NVMAPPINGTABLE_H
+//MappingTable.h
+//header file for the ftl's virtual to physical address map
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include "FlashConfiguration.h"
+
+// returned for a virtual address that hasn't been written yet
+#define NO_MAPPING ((uint64_t) -1)
+// the same thing in a table entry that only holds 32 bits
+#define NARROW_UNMAPPED ((uint32_t) -1)
+
+namespace NVDSim{
+	// One entry per virtual page holding the physical page number that page was written to.
+	// The physical page numbers are stored in 32 bits whenever the device is small enough for them to fit.
+	// Addresses that don't fall on the start of a page are kept in a hash map on the side so
+	// they still get their own mapping like they always have.
+	class MappingTable{
+		public:
+			MappingTable(void);
+
+			uint64_t lookup(uint64_t vAddr);
+			void map(uint64_t vAddr, uint64_t pAddr);
+			uint64_t size(void);
+
+			// raw access to the table for checkpoints
+			uint64_t pages(void) const { return num_pages; }
+			uint64_t entryBytes(void) const { return narrow ? sizeof(uint32_t) : sizeof(uint64_t); }
+			const void *entries(void) const { return narrow ? (const void *) narrow_entries.data() : (const void *) wide_entries.data(); }
+			const std::unordered_map<uint64_t, uint64_t> &unalignedEntries(void) const { return unaligned; }
+			// replaces the whole table, entries is laid out like entries() and pairs holds count vAddr, pAddr pairs
+			void load(const void *entries, const uint64_t *pairs, uint64_t count);
+
+			// calls f(vAddr, pAddr) for every mapped address
+			template <typename Function>
+			void forEach(Function f)
+			{
+				uint64_t i, entry;
+				for (i = 0; i < num_pages; i++)
+				{
+					entry = narrow ? narrow_entries[i] : wide_entries[i];
+					if (entry != (narrow ? NARROW_UNMAPPED : NO_MAPPING))
+						f(i * page_bytes, entry * NV_PAGE_SIZE);
+				}
+
+				std::unordered_map<uint64_t, uint64_t>::iterator it;
+				for (it = unaligned.begin(); it != unaligned.end(); it++)
+					f((*it).first, (*it).second);
+			}
+
+		private:
+			uint64_t num_pages;
+			uint64_t page_bytes;
+			uint64_t mapped;
+
+			bool narrow;
+			std::vector<uint32_t> narrow_entries;
+			std::vector<uint64_t> wide_entries;
+
+			std::unordered_map<uint64_t, uint64_t> unaligned;
+	};
+}
+#endif
@@ -48,8 +48,11 @@ namespace NVDSim
 	sys(sysFile),
 	cDirectory(pwd)
     {
-	uint64_t i, j;
 	systemID = id;
+
+	// our config stays installed on this thread after we're built so code that reads it between
+	// calls into us still works when there is only one NVDIMM
+	current_config = &config;
 	
 	 if (cDirectory.length() > 0)
 	 {
@@ -64,15 +67,36 @@ namespace NVDSim
 		 sys = pwd + "/" + sys;
 		 }
 	}
-	Init::ReadIniFile(dev, false);
-	//Init::ReadIniFile(sys, true);
+	Init init(&config);
+	init.ReadIniFile(dev, false);
+	//init.ReadIniFile(sys, true);
 
-	 if (!Init::CheckIfAllSet())
+	 if (!init.CheckIfAllSet())
 	 {
 		 exit(-1);
 	 }
-	
-	BLOCKS_PER_PLANE = (uint64_t) VIRTUAL_BLOCKS_PER_PLANE * PBLOCKS_PER_VBLOCK;
+
+	build();
+    }
+
+    // for a config that has already been read in, like each point of a parameter sweep
+    NVDIMM::NVDIMM(uint id, const Config &c) :
+	config(c)
+    {
+	systemID = id;
+
+	current_config = &config;
+
+	build();
+    }
+
+    // everything else is built from the config
+    void NVDIMM::build(void){
+	uint64_t i, j;
+
+	// SimObj picked up whatever config was current when this was constructed
+	params = &config;
+
 	if(LOGGING == 1)
 	{
 	    PRINT("Logs are being generated");
@@ -204,6 +228,7 @@ namespace NVDSim
 	    ftl = new Ftl(controller, log, this);
 	}
 	packages= new vector<Package>();
+	packet_pools= new ObjectPool<ChannelPacket> [NUM_PACKAGES];
 
 	if (DIES_PER_PACKAGE > INT_MAX){
 		ERROR("Too many dies.");
@@ -230,7 +255,27 @@ namespace NVDSim
 	controller->attachPackages(packages);
 	
 	ReturnReadData= NULL;
+	CriticalLineDone= NULL;
 	WriteDataDone= NULL;
+	ReturnPowerData= NULL;
+	TaggedReadDone= NULL;
+	TaggedCritLineDone= NULL;
+	TaggedWriteDone= NULL;
+	PowerDataReady= NULL;
+	completions= NULL;
+	next_request_id= 0;
+
+	nv_save= ENABLE_NV_SAVE;
+	nv_save_file= NV_SAVE_FILE;
+	nv_restore= ENABLE_NV_RESTORE;
+	nv_restore_file= NV_RESTORE_FILE;
+
+	power_data.cycle = 0;
+	power_data.num_packages = NUM_PACKAGES;
+	for(i = 0; i < NUM_POWER_FIELDS; i++){
+	    power_storage[i] = new double [NUM_PACKAGES];
+	    power_data.energy[i] = NULL;
+	}
 
 	epoch_count = 0;
 	epoch_cycles = 0;
@@ -243,6 +288,7 @@ namespace NVDSim
 	for(uint64_t h = 0; h < NUM_PACKAGES; h++){
 	    cycles_left[h] = 0;
 	}
+	controller_cycles_left = 0;
 	// the channel and buffers are running faster than the other parts of the system
 	if(CYCLE_TIME > CHANNEL_CYCLE)
 	{
@@ -256,23 +302,213 @@ namespace NVDSim
 	}
 	cout << "the faster cycles computed was: " << channel_cycles_per_cycle << " \n";
 
+	// indexed by buffered and logging
+	static void (NVDIMM::*const kernels[4])(void) = {
+		&NVDIMM::updateKernel<0,0>, &NVDIMM::updateKernel<0,1>, &NVDIMM::updateKernel<1,0>, &NVDIMM::updateKernel<1,1>
+	};
+#ifdef GENERIC_KERNELS
+	update_kernel = &NVDIMM::updateKernel<RUNTIME_FLAG, RUNTIME_FLAG>;
+	package_kernel = &NVDIMM::updatePackages<RUNTIME_FLAG>;
+#else
+	update_kernel = kernels[(BUFFERED ? 2 : 0) + (LOGGING ? 1 : 0)];
+	package_kernel = BUFFERED ? &NVDIMM::updatePackages<1> : &NVDIMM::updatePackages<0>;
+#endif
+
+	deferring_events = false;
+	package_events = vector<vector<function<void()> > >(NUM_PACKAGES, vector<function<void()> >());
+	startWorkers();
+	if(!workers.empty())
+	{
+	    PRINT("Packages are being updated by "<<workers.size() + 1<<" threads");
+	}
+
 	ftl->loadNVState();
     }
 
+    NVDIMM::~NVDIMM(void){
+	uint64_t i, j;
+
+	// don't leave this thread pointing at our config once it is gone
+	if(current_config == &config)
+	{
+	    current_config = NULL;
+	}
+	ConfigScope scope(&config);
+
+	stopWorkers();
+	if(LOGGING)
+	{
+	    log->closeEventLogs();
+	}
+
+	// everything build made, in the reverse order
+	for(i = 0; i < NUM_POWER_FIELDS; i++){
+	    delete [] power_storage[i];
+	}
+	delete completions;
+	delete [] cycles_left;
+
+	for(i = packages->size(); i > 0; i--){
+	    for(j = 0; j < (*packages)[i-1].dies.size(); j++){
+		delete (*packages)[i-1].dies[j];
+	    }
+	    delete (*packages)[i-1].buffer;
+	    delete (*packages)[i-1].channel;
+	}
+	delete packages;
+
+	delete ftl;
+	delete controller;
+	delete log;
+
+	// the packets still in flight point into the pools so they go last
+	delete [] packet_pools;
+    }
+
+    // split the packages up between the threads, the thread calling update does the first shard
+    void NVDIMM::startWorkers(void){
+	uint64_t i;
+
+	stop_workers = false;
+	package_phase = 0;
+	shards_done = 0;
+	shard_start.clear();
+	if(PARALLEL_THREADS > 1 && NUM_PACKAGES > 1)
+	{
+	    uint64_t shards = (PARALLEL_THREADS < NUM_PACKAGES) ? PARALLEL_THREADS : NUM_PACKAGES;
+	    for(i = 0; i <= shards; i++)
+	    {
+		shard_start.push_back((i * NUM_PACKAGES) / shards);
+	    }
+	    for(i = 1; i < shards; i++)
+	    {
+		workers.push_back(thread(&NVDIMM::workerLoop, this, i));
+	    }
+	}
+    }
+
+    void NVDIMM::stopWorkers(void){
+	// wake the workers up one last time so they can exit
+	stop_workers = true;
+	package_phase++;
+	for(uint64_t i = 0; i < workers.size(); i++)
+	{
+	    workers[i].join();
+	}
+	workers.clear();
+    }
+
+    // Only the thread that calls fork is copied into the child, so the workers are stopped first and
+    // started again on both sides.
+    // The event logs are closed and open again when they are next used.
+    // The child's logs and saved state get their own names so the copies don't write over each other.
+    pid_t NVDIMM::forkSimulation(string tag){
+	ConfigScope scope(&config);
+	pid_t pid;
+
+	stopWorkers();
+	// the event log writer is a thread too
+	if(LOGGING)
+	{
+	    log->closeEventLogs();
+	}
+
+	// anything still buffered would be written out by both processes
+	cout.flush();
+	cerr.flush();
+	fflush(NULL);
+
+	pid = fork();
+	if(pid < 0)
+	{
+	    ERROR("Could not fork the simulation");
+	    abort();
+	}
+
+	if(pid == 0 && tag != "")
+	{
+	    tagOutputFiles(tag);
+	}
+
+	startWorkers();
+	return pid;
+    }
+
+    void NVDIMM::tagOutputFiles(string tag){
+	if(log != NULL)
+	{
+	    string dir = log->log_dir;
+	    if (dir.length() > 0 && dir[dir.length()-1] == '/')
+	    {
+		dir = dir.substr(0, dir.length()-1) + "_" + tag + "/";
+	    }
+	    else
+	    {
+		dir = dir + "_" + tag;
+	    }
+	    log->setLogDir(dir);
+	}
+	nv_save_file = nv_save_file + "." + tag;
+    }
+
 // static allocator for the library interface
     NVDIMM *getNVDIMMInstance(uint id, string deviceFile, string sysFile, string pwd, string trc)
     {
 	return new NVDIMM(id, deviceFile, sysFile, pwd, trc);
     }
 
+    // the id is only used up if the ftl takes the request
     bool NVDIMM::add(FlashTransaction &trans){
-	return ftl->addTransaction(trans);	
+	ConfigScope scope(&config);
+	trans.id = next_request_id;
+	if(!ftl->addTransaction(trans))
+	{
+	    return false;
+	}
+	next_request_id++;
+	return true;
     }
 
     bool NVDIMM::addTransaction(bool isWrite, uint64_t addr){
+	uint64_t id;
+	return addTransaction(isWrite, addr, &id);
+    }
+
+    bool NVDIMM::addTransaction(bool isWrite, uint64_t addr, uint64_t *id){
 	TransactionType type = isWrite ? DATA_WRITE : DATA_READ;
 	FlashTransaction trans = FlashTransaction(type, addr, NULL);
-	return ftl->addTransaction(trans);
+	bool result = add(trans);
+	*id = trans.id;
+	return result;
+    }
+
+    // Fast forward a transaction, its effects on the ftl and the planes happen right away with no timing.
+    // This is for warming up the device before the detailed simulation starts so the queues should be empty.
+    void NVDIMM::addFfTransaction(bool isWrite, uint64_t addr){
+	ConfigScope scope(&config);
+	TransactionType type = isWrite ? DATA_WRITE : DATA_READ;
+	FlashTransaction trans = FlashTransaction(type, addr, NULL);
+	ftl->addFfTransaction(trans);
+    }
+
+    // One config switch for the whole batch instead of one per request. The requests are tried in order
+    // and one being turned away doesn't stop the rest, a write can still get in when the reads are full.
+    uint NVDIMM::addBatch(HostRequest *requests, uint count, bool *accepted){
+	ConfigScope scope(&config);
+	uint taken = 0;
+
+	for(uint i = 0; i < count; i++)
+	{
+	    TransactionType type = requests[i].isWrite ? DATA_WRITE : DATA_READ;
+	    FlashTransaction trans = FlashTransaction(type, next_request_id, requests[i].address, NULL);
+	    accepted[i] = ftl->addTransaction(trans);
+	    if(accepted[i])
+	    {
+		requests[i].id = next_request_id++;
+		taken++;
+	    }
+	}
+	return taken;
     }
 
     string NVDIMM::SetOutputFileName(string tracefilename){
@@ -294,7 +530,92 @@ namespace NVDSim
 	ReturnPowerData = Power;
     }
 
+    void NVDIMM::RegisterTaggedCallbacks(Callback_t *readCB, Callback_t *critLineCB, Callback_t *writeCB)
+    {
+	TaggedReadDone = readCB;
+	TaggedCritLineDone = critLineCB;
+	TaggedWriteDone = writeCB;
+    }
+
+    void NVDIMM::RegisterPowerCallback(Callback_p *Power)
+    {
+	PowerDataReady = Power;
+    }
+
+    void NVDIMM::EnableCompletionRing(uint64_t entries)
+    {
+	delete completions;
+	completions = (entries > 0) ? new CompletionRing(entries) : NULL;
+    }
+
+    uint64_t NVDIMM::drainCompletions(Completion *out, uint64_t max)
+    {
+	if(completions == NULL)
+	{
+	    return 0;
+	}
+	return completions->drain(out, max);
+    }
+
+    uint64_t NVDIMM::droppedCompletions(void)
+    {
+	if(completions == NULL)
+	{
+	    return 0;
+	}
+	return completions->dropped();
+    }
+
+    void NVDIMM::readDone(uint64_t id, uint64_t addr, uint64_t cycle, bool mapped)
+    {
+	if(ReturnReadData != NULL)
+	{
+	    (*ReturnReadData)(systemID, addr, cycle, mapped);
+	}
+	if(TaggedReadDone != NULL)
+	{
+	    (*TaggedReadDone)(systemID, id, cycle, mapped);
+	}
+	if(completions != NULL)
+	{
+	    completions->push(id, addr, READ_COMPLETION, cycle, mapped);
+	}
+    }
+
+    void NVDIMM::critLineDone(uint64_t id, uint64_t addr, uint64_t cycle)
+    {
+	if(CriticalLineDone != NULL)
+	{
+	    (*CriticalLineDone)(systemID, addr, cycle, true);
+	}
+	if(TaggedCritLineDone != NULL)
+	{
+	    (*TaggedCritLineDone)(systemID, id, cycle, true);
+	}
+	if(completions != NULL)
+	{
+	    completions->push(id, addr, CRIT_LINE_COMPLETION, cycle, true);
+	}
+    }
+
+    void NVDIMM::writeDone(uint64_t id, uint64_t addr, uint64_t cycle)
+    {
+	if(WriteDataDone != NULL)
+	{
+	    (*WriteDataDone)(systemID, addr, cycle, true);
+	}
+	if(TaggedWriteDone != NULL)
+	{
+	    (*TaggedWriteDone)(systemID, id, cycle, true);
+	}
+	if(completions != NULL)
+	{
+	    completions->push(id, addr, WRITE_COMPLETION, cycle, true);
+	}
+    }
+
     void NVDIMM::printStats(void){
+	ConfigScope scope(&config);
 	if(LOGGING == true)
 	{
 	    log->print(currentClockCycle);
@@ -302,58 +623,61 @@ namespace NVDSim
     }
 
     void NVDIMM::saveStats(void){
+	ConfigScope scope(&config);
 	if(LOGGING == true)
 	{
 	    log->save(currentClockCycle, epoch_count);
+	    log->closeEventLogs();
 	}
 	ftl->saveNVState();
     }
 
     void NVDIMM::update(void){
-	uint64_t i, j;
-	Package package;
-	
-	for (i= 0; i < packages->size(); i++){
-		package= (*packages)[i];
-		if(BUFFERED)
+	ConfigScope scope(&config);
+	(this->*update_kernel)();
+    }
+
+    template <int buffered, int logging>
+    void NVDIMM::updateKernel(void){
+	uint64_t i, j, spins;
+
+	if(workers.empty())
+	{
+	    updatePackages<buffered>(0, packages->size());
+	}
+	else
+	{
+	    // start the workers on this cycle and do our own share of the packages
+	    deferring_events = true;
+	    shards_done = 0;
+	    package_phase++;
+	    updatePackages<buffered>(shard_start[0], shard_start[1]);
+
+	    // wait for everyone else to finish
+	    spins = 0;
+	    while(shards_done < workers.size())
+	    {
+		if(++spins > 1000)
 		{
-		    if(faster_channel)
-		    {
-			for(uint64_t c = 0; c < channel_cycles_per_cycle; c++)
-			{
-			    package.channel->update();
-			    package.buffer->update();
-			}
-		    }
-		    else
-		    {
-			// reset the update counter and update the channel
-			if(cycles_left[i] == 0)
-			{
-			    package.channel->update();
-			    package.buffer->update();
-			    cycles_left[i] = channel_cycles_per_cycle;
-			}
-			
-			cycles_left[i] = cycles_left[i] - 1;
-		    }
+		    this_thread::yield();
 		}
-		else
-		{
-		    package.channel->update();
-		    package.buffer->update();
-		}		
-		for (j= 0; j < package.dies.size() ; j++)
+	    }
+	    deferring_events = false;
+
+	    // now that the packages are done, run whatever they did to the rest of the system in order
+	    for (i= 0; i < packages->size(); i++){
+		for (j= 0; j < package_events[i].size(); j++)
 		{
-			package.dies[j]->update();
-			package.dies[j]->step();
+		    package_events[i][j]();
 		}
+		package_events[i].clear();
+	    }
 	}
 	
 	ftl->update();
 	ftl->step();
 
-	if(BUFFERED)
+	if(KERNEL_FLAG(buffered, BUFFERED))
 	{
 	    if(faster_channel)
 	    {
@@ -382,7 +706,7 @@ namespace NVDSim
 	    controller->step();
 	}
 
-	if(LOGGING == true)
+	if(KERNEL_FLAG(logging, LOGGING))
 	{
 	    log->update();
 	}
@@ -392,11 +716,9 @@ namespace NVDSim
 	//saving stats at the end of each epoch
 	if(USE_EPOCHS)
 	{
-	    ftl->sendQueueLength();
-	    controller->sendQueueLength();
 	    if(epoch_cycles >= EPOCH_TIME)
 	    {
-		if(LOGGING == true)
+		if(KERNEL_FLAG(logging, LOGGING))
 		{
 		    log->save_epoch(currentClockCycle, epoch_count);
 		    log->ftlQueueReset();
@@ -414,23 +736,268 @@ namespace NVDSim
 	//cout << "NVDIMM successfully updated" << endl;
     }
 
+    // number of cycles until something in the system can change state
+    // 0 means the next update has real work to do
+    uint64_t NVDIMM::nextEvent(void){
+	ConfigScope scope(&config);
+	uint64_t i, j, next, temp;
+
+	next = ftl->nextEvent();
+	if(next == 0)
+	{
+	    return 0;
+	}
+
+	temp = controller->nextEvent();
+	if(temp < next)
+	{
+	    next = temp;
+	}
+
+	for (i= 0; i < packages->size() && next > 0; i++){
+	    temp = (*packages)[i].channel->nextEvent();
+	    if(temp < next)
+	    {
+		next = temp;
+	    }
+	    temp = (*packages)[i].buffer->nextEvent();
+	    if(temp < next)
+	    {
+		next = temp;
+	    }
+	    for (j= 0; j < (*packages)[i].dies.size(); j++)
+	    {
+		temp = (*packages)[i].dies[j]->nextEvent();
+		if(temp < next)
+		{
+		    next = temp;
+		}
+	    }
+	}
+
+	// the epoch data has to be saved on the right cycle
+	if(USE_EPOCHS)
+	{
+	    temp = (epoch_cycles < EPOCH_TIME) ? EPOCH_TIME - epoch_cycles : 0;
+	    if(temp < next)
+	    {
+		next = temp;
+	    }
+	}
+
+	return next;
+    }
+
+    // run the system until currentClockCycle reaches cycle, jumping over any stretch where
+    // nothing is going on instead of calling update for every one of those cycles
+    void NVDIMM::advanceTo(uint64_t cycle){
+	ConfigScope scope(&config);
+	uint64_t next;
+
+	while(currentClockCycle < cycle)
+	{
+	    next = nextEvent();
+	    if(next == 0)
+	    {
+		update();
+	    }
+	    else
+	    {
+		if(next > cycle - currentClockCycle)
+		{
+		    next = cycle - currentClockCycle;
+		}
+		skipCycles(next);
+	    }
+	}
+    }
+
+    // the cycle the system has been run up to, so hosts driving it with advanceTo know where it stands
+    uint64_t NVDIMM::getCycle(void){
+	return currentClockCycle;
+    }
+
+    // does the bookkeeping that cycles calls to update would have done while the system was idle
+    // should only ever be called with cycles no larger than nextEvent()
+    void NVDIMM::skipCycles(uint64_t cycles){
+	uint64_t i, j;
+
+	for (i= 0; i < packages->size(); i++){
+	    // the slower channels only update every channel_cycles_per_cycle so keep their phase
+	    if(BUFFERED && !faster_channel)
+	    {
+		cycles_left[i] = (cycles_left[i] + channel_cycles_per_cycle - (cycles % channel_cycles_per_cycle)) % channel_cycles_per_cycle;
+	    }
+	    for (j= 0; j < (*packages)[i].dies.size(); j++)
+	    {
+		(*packages)[i].dies[j]->skipCycles(cycles);
+	    }
+	}
+
+	ftl->skipCycles(cycles);
+
+	// the controller clock only moves when the controller is updated
+	if(BUFFERED)
+	{
+	    if(faster_channel)
+	    {
+		controller->currentClockCycle += cycles * channel_cycles_per_cycle;
+	    }
+	    else
+	    {
+		if(cycles > controller_cycles_left)
+		{
+		    controller->currentClockCycle += 1 + (cycles - 1 - controller_cycles_left) / channel_cycles_per_cycle;
+		}
+		controller_cycles_left = (controller_cycles_left + channel_cycles_per_cycle - (cycles % channel_cycles_per_cycle)) % channel_cycles_per_cycle;
+	    }
+	}
+	else
+	{
+	    controller->currentClockCycle += cycles;
+	}
+
+	if(LOGGING == true)
+	{
+	    log->skipCycles(cycles);
+	}
+
+	currentClockCycle += cycles;
+
+	if(USE_EPOCHS)
+	{
+	    epoch_cycles += cycles;
+	}
+    }
+
+    template <int buffered>
+    void NVDIMM::updatePackage(uint64_t i){
+	uint64_t j;
+	Package &package= (*packages)[i];
+
+	if(KERNEL_FLAG(buffered, BUFFERED))
+	{
+	    if(faster_channel)
+	    {
+		for(uint64_t c = 0; c < channel_cycles_per_cycle; c++)
+		{
+		    package.channel->update();
+		    package.buffer->update();
+		}
+	    }
+	    else
+	    {
+		// reset the update counter and update the channel
+		if(cycles_left[i] == 0)
+		{
+		    package.channel->update();
+		    package.buffer->update();
+		    cycles_left[i] = channel_cycles_per_cycle;
+		}
+		
+		cycles_left[i] = cycles_left[i] - 1;
+	    }
+	}
+	else
+	{
+	    package.channel->update();
+	    package.buffer->update();
+	}		
+	for (j= 0; j < package.dies.size() ; j++)
+	{
+		package.dies[j]->update();
+		package.dies[j]->step();
+	}
+    }
+
+    template <int buffered>
+    void NVDIMM::updatePackages(uint64_t first, uint64_t last){
+	for (uint64_t i= first; i < last; i++){
+	    updatePackage<buffered>(i);
+	}
+    }
+
+    // each worker waits for update to start a new cycle and then updates its shard of the packages
+    void NVDIMM::workerLoop(uint64_t worker){
+	uint64_t phase = 0, spins;
+
+	current_config = &config;
+
+	while(true)
+	{
+	    spins = 0;
+	    while(package_phase == phase)
+	    {
+		if(++spins > 1000)
+		{
+		    this_thread::yield();
+		}
+	    }
+	    phase = package_phase;
+
+	    if(stop_workers)
+	    {
+		return;
+	    }
+
+	    (this->*package_kernel)(shard_start[worker], shard_start[worker+1]);
+	    shards_done++;
+	}
+    }
+
     void NVDIMM::powerCallback(void){
-	ftl->powerCallback();
+	ConfigScope scope(&config);
+	if(ReturnPowerData != NULL)
+	{
+	    ftl->powerCallback();
+	}
+	if(PowerDataReady != NULL)
+	{
+	    (*PowerDataReady)(systemID, getPowerData(), currentClockCycle, false);
+	}
+    }
+
+    // refills power_data in place from the logger's energy, the fields are in the same units as the
+    // power callback
+    const PowerData &NVDIMM::getPowerData(void){
+	ConfigScope scope(&config);
+	uint64_t f, i;
+
+	power_data.cycle = currentClockCycle;
+	for(f = 0; f < NUM_POWER_FIELDS; f++)
+	{
+	    const vector<double> *energy = (log != NULL) ? log->getEnergyField((PowerField)f) : NULL;
+	    if(energy == NULL)
+	    {
+		power_data.energy[f] = NULL;
+		continue;
+	    }
+
+	    double scale = (f < VPP_IDLE_ENERGY) ? VCC : VPP;
+	    power_data.energy[f] = power_storage[f];
+	    for(i = 0; i < NUM_PACKAGES; i++)
+	    {
+		power_data.energy[f][i] = (*energy)[i] * scale;
+	    }
+	}
+	return power_data;
     }
 
 //If either of these methods are called it is because HybridSim called them
 //therefore the appropriate system setting should be set
     void NVDIMM::saveNVState(string filename){
-	ENABLE_NV_SAVE = 1;
-	NV_SAVE_FILE = filename;
+	ConfigScope scope(&config);
+	nv_save = true;
+	nv_save_file = filename;
 	cout << "got to save state in nvdimm \n";
-	cout << "save file was " << NV_SAVE_FILE << "\n";
+	cout << "save file was " << nv_save_file << "\n";
 	ftl->saveNVState();
     }
 
     void NVDIMM::loadNVState(string filename){
-	ENABLE_NV_RESTORE = 1;
-	NV_RESTORE_FILE = filename;
+	ConfigScope scope(&config);
+	nv_restore = true;
+	nv_restore_file = filename;
 	ftl->loadNVState();
     }
 
@@ -443,4 +1010,16 @@ namespace NVDSim
     {
 	ftl->GCReadDone(vAddr);
     }
+
+    ChannelPacket *NVDIMM::allocatePacket(ChannelPacketType type, uint64_t id, uint64_t vAddr, uint64_t pAddr, uint page, uint block, uint plane, uint die, uint package)
+    {
+	ChannelPacket *packet = packet_pools[package].get();
+	*packet = ChannelPacket(type, id, vAddr, pAddr, page, block, plane, die, package, NULL);
+	return packet;
+    }
+
+    void NVDIMM::releasePacket(ChannelPacket *packet)
+    {
+	packet_pools[packet->package].put(packet);
+    }
 }
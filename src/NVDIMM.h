@@ -48,33 +48,97 @@
 #include "GCLogger.h"
 #include "P8PLogger.h"
 #include "P8PGCLogger.h"
+#include "ObjectPool.h"
+#include "HostInterface.h"
+#include "CompletionRing.h"
+
+#include <thread>
+#include <unistd.h>
+#include <atomic>
+#include <functional>
 
 using std::string;
 
 namespace NVDSim{
     typedef CallbackBase<void,uint,uint64_t,uint64_t,bool> Callback_t;
     typedef CallbackBase<void,uint,vector<vector<double>>,uint64_t,bool> Callback_v;
+    typedef CallbackBase<void,uint,const PowerData &,uint64_t,bool> Callback_p;
 	class NVDIMM : public SimObj{
 		public:
 			NVDIMM(uint id, string dev, string sys, string pwd, string trc);
+			NVDIMM(uint id, const Config &config);
+			~NVDIMM(void);
 			void update(void);
+			uint64_t nextEvent(void);
+			void advanceTo(uint64_t cycle);
+			uint64_t getCycle(void);
+			// trans.id is set to the request's id if it is accepted
 			bool add(FlashTransaction &trans);
 			bool addTransaction(bool isWrite, uint64_t addr);
+			bool addTransaction(bool isWrite, uint64_t addr, uint64_t *id);
+			void addFfTransaction(bool isWrite, uint64_t addr);
+			// accepted[i] says whether requests[i] made it into the ftl and if it did requests[i].id is
+			// set, returns how many did
+			uint addBatch(HostRequest *requests, uint count, bool *accepted);
 			void printStats(void);
 			void saveStats(void);
 			string SetOutputFileName(string tracefilename);
 			void RegisterCallbacks(Callback_t *readDone, Callback_t *writeDone, Callback_v *Power);
 			void RegisterCallbacks(Callback_t *readDone, Callback_t *critLine, Callback_t *writeDone, Callback_v *Power); 
+			// these callbacks are given the request id where the others are given the address
+			void RegisterTaggedCallbacks(Callback_t *readDone, Callback_t *critLine, Callback_t *writeDone);
+			void RegisterPowerCallback(Callback_p *Power);
+
+			// queue completions on a ring of this many entries as well as making the callbacks
+			void EnableCompletionRing(uint64_t entries);
+			uint64_t drainCompletions(Completion *out, uint64_t max);
+			uint64_t droppedCompletions(void);
 
 			void powerCallback(void);
+			const PowerData &getPowerData(void);
+
+			// everything that finishes a host request comes through these
+			void readDone(uint64_t id, uint64_t addr, uint64_t cycle, bool mapped);
+			void critLineDone(uint64_t id, uint64_t addr, uint64_t cycle);
+			void writeDone(uint64_t id, uint64_t addr, uint64_t cycle);
+
+			// ids for requests that start inside the simulator, like the gc's
+			uint64_t newRequestId(void) { return next_request_id++; }
 
 			void saveNVState(string filename);
 			void loadNVState(string filename);
 
+			// copies the whole simulator, including everything in flight, into a new process
+			// returns 0 in the new process and its pid in this one, see NVDIMM.cpp
+			pid_t forkSimulation(string tag);
+			// gives the log directory and the save file their own names for one of several copies of a device
+			void tagOutputFiles(string tag);
+
 			void queuesNotFull(void);
 
 			void GCReadDone(uint64_t vAddr);
 
+			// channel packets come from a pool for each package, the package's pool is only touched
+			// by whoever is updating that package or outside of the package update
+			ChannelPacket *allocatePacket(ChannelPacketType type, uint64_t id, uint64_t vAddr, uint64_t pAddr, uint page, uint block, uint plane, uint die, uint package);
+			void releasePacket(ChannelPacket *packet);
+
+			// anything a package does during its update that touches state outside of that package
+			// goes through here, when the packages are being updated in parallel the event is held
+			// and then run in package order once they are all done so we get the same results as
+			// a serial update
+			template <typename Event> void packageEvent(uint64_t package, Event event)
+			{
+				if (deferring_events)
+				{
+					package_events[package].push_back(std::function<void()>(event));
+				}
+				else
+				{
+					event();
+				}
+			}
+
 			Controller *controller;
 			Ftl *ftl;
 			Logger *log;
@@ -84,9 +148,18 @@ namespace NVDSim{
 			Callback_t* ReturnReadData;
 			Callback_t* CriticalLineDone;
 			Callback_t* WriteDataDone;
+			Callback_t* TaggedReadDone;
+			Callback_t* TaggedCritLineDone;
+			Callback_t* TaggedWriteDone;
 			Callback_v* ReturnPowerData;
+			Callback_p* PowerDataReady;
 
 			uint systemID, numReads, numWrites, numErases;
+
+			// where the ftl state is saved to and restored from, these start out as the ini parameters but
+			// saveNVState, loadNVState and tagOutputFiles change them here and leave the Config alone
+			bool nv_save, nv_restore;
+			string nv_save_file, nv_restore_file;
 			uint epoch_count, epoch_cycles;
 			uint64_t channel_cycles_per_cycle, controller_cycles_left;
 			uint64_t* cycles_left;
@@ -94,6 +167,39 @@ namespace NVDSim{
 			bool faster_channel;
 
 		private:
+			void build(void);
+			void skipCycles(uint64_t cycles);
+
+			// the updates for this NVDIMM's flags, see FlashConfiguration.h
+			template <int buffered, int logging> void updateKernel(void);
+			template <int buffered> void updatePackage(uint64_t i);
+			template <int buffered> void updatePackages(uint64_t first, uint64_t last);
+			void (NVDIMM::*update_kernel)(void);
+			void (NVDIMM::*package_kernel)(uint64_t first, uint64_t last);
+			void workerLoop(uint64_t worker);
+			void startWorkers(void);
+			void stopWorkers(void);
+
+			// parallel package update state
+			std::vector<std::thread> workers;
+			std::vector<uint64_t> shard_start; //first package of each shard, shard 0 is done by the calling thread
+			std::atomic<uint64_t> package_phase; //bumped to start the workers on a cycle
+			std::atomic<uint64_t> shards_done;
+			bool stop_workers;
+			bool deferring_events;
+			std::vector<std::vector<std::function<void()> > > package_events;
+
+			ObjectPool<ChannelPacket> *packet_pools;
+
+			uint64_t next_request_id;
+
+			CompletionRing *completions;
+			PowerData power_data;
+			double *power_storage[NUM_POWER_FIELDS];
+
+			// everything under this NVDIMM reads its parameters from here, see FlashConfiguration.h
+			Config config;
+
 			string dev, sys, cDirectory;
 	};
 
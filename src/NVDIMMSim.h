@@ -6,6 +6,7 @@
  */
 
 #include "Callbacks.h"
+#include "HostInterface.h"
 
 #include <iostream>
 #include <cstdlib>
@@ -17,6 +18,7 @@
 #include <list>
 #include <stdint.h>
 #include <limits.h>
+#include <unistd.h>
 
 using std::string;
 
@@ -24,18 +26,38 @@ namespace NVDSim
 {
     typedef CallbackBase<void,uint,uint64_t,uint64_t,bool> Callback_t;
     typedef CallbackBase<void,uint,std::vector<std::vector<double>>,uint64_t,bool> Callback_v;
+    typedef CallbackBase<void,uint,const PowerData &,uint64_t,bool> Callback_p;
     class NVDIMM
     {
     public:
 	void update(void);
+	// cycles until the next update that has real work to do, 0 means the next one does
+	uint64_t nextEvent(void);
+	// runs the system up to cycle, skipping over idle stretches instead of updating through them
+	void advanceTo(uint64_t cycle);
+	uint64_t getCycle(void);
 	bool addTransaction(bool isWrite, uint64_t addr);
+	bool addTransaction(bool isWrite, uint64_t addr, uint64_t *id);
+	void addFfTransaction(bool isWrite, uint64_t addr);
+	uint addBatch(HostRequest *requests, uint count, bool *accepted);
 	void printStats(void);
 	void saveStats(void);
 	void RegisterCallbacks(Callback_t *readDone, Callback_t *writeDone, Callback_v *Power);
 	void RegisterCallbacks(Callback_t *readDone, Callback_t *critLine, Callback_t *writeDone, Callback_v *Power); 
+	void RegisterTaggedCallbacks(Callback_t *readDone, Callback_t *critLine, Callback_t *writeDone);
+	void RegisterPowerCallback(Callback_p *Power);
+
+	void EnableCompletionRing(uint64_t entries);
+	uint64_t drainCompletions(Completion *out, uint64_t max);
+	uint64_t droppedCompletions(void);
+
+	void powerCallback(void);
+	const PowerData &getPowerData(void);
 
 	void saveNVState(string filename);
 	void loadNVState(string filename);
+
+	pid_t forkSimulation(string tag);
     };
 
     NVDIMM *getNVDIMMInstance(uint id, string deviceFile, string sysFile, string pwd, string trc);
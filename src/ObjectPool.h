@@ -0,0 +1,106 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVOBJECTPOOL_H
+#define NVOBJECTPOOL_H
+//ObjectPool.h
+//header file for a pool of reusable objects
+
+#include <vector>
+#include <stdint.h>
+
+namespace NVDSim{
+	// Hands out objects that are allocated a slab at a time and recycled through a free list, so
+	// objects that are made and thrown away on every access don't go through the heap each time.
+	// Objects aren't reconstructed when they're handed out again so the caller should assign every field.
+	// A pool isn't thread safe, each pool must only be used by one thread at a time.
+	template <typename T>
+	class ObjectPool{
+		public:
+			ObjectPool(uint64_t slab = 256)
+			{
+				slab_size = slab;
+			}
+
+			~ObjectPool(void)
+			{
+				for (uint64_t i = 0; i < slabs.size(); i++)
+				{
+					delete [] slabs[i];
+				}
+			}
+
+			T *get(void)
+			{
+				if (free_list.empty())
+				{
+					grow();
+				}
+				T *obj = free_list.back();
+				free_list.pop_back();
+				return obj;
+			}
+
+			void put(T *obj)
+			{
+				free_list.push_back(obj);
+			}
+
+			// objects handed out and not put back yet
+			uint64_t inUse(void)
+			{
+				return slabs.size() * slab_size - free_list.size();
+			}
+
+		private:
+			void grow(void)
+			{
+				T *slab = new T[slab_size];
+				slabs.push_back(slab);
+				// push them backwards so they get handed out in order
+				for (uint64_t i = slab_size; i > 0; i--)
+				{
+					free_list.push_back(&slab[i-1]);
+				}
+			}
+
+			// the pool owns the slabs so it can't be copied
+			ObjectPool(const ObjectPool &);
+			ObjectPool &operator=(const ObjectPool &);
+
+			uint64_t slab_size;
+			std::vector<T *> slabs;
+			std::vector<T *> free_list;
+	};
+}
+#endif
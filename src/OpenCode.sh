@@ -1,7 +1,7 @@
 #!/bin/sh
 
-emacs Util.cpp TraceBasedSim.cpp SimObj.cpp Plane.cpp NVDIMM.cpp Init.cpp P8PGCLogger.cpp P8PLogger.cpp GCLogger.cpp Logger.cpp GCFtl.cpp Ftl.cpp FlashTransaction.cpp  Die.cpp Controller.cpp ChannelPacket.cpp Channel.cpp Buffer.cpp Block.cpp --eval '(delete-other-windows)'&
+emacs Util.cpp TraceBasedSim.cpp SweepSim.cpp LogConvert.cpp TraceDriver.cpp TraceReader.cpp ThreadedNVDIMM.cpp SimObj.cpp Plane.cpp LatencyHistogram.cpp NVDIMM.cpp Init.cpp P8PGCLogger.cpp P8PLogger.cpp GCLogger.cpp Logger.cpp EventLog.cpp GCFtl.cpp Ftl.cpp Checkpoint.cpp CompletionRing.cpp MappingTable.cpp PageBitmap.cpp FlashTransaction.cpp  Die.cpp Controller.cpp ChannelPacket.cpp Channel.cpp Buffer.cpp Block.cpp --eval '(delete-other-windows)'&
 
-emacs Util.h TraceBasedSim.h SimObj.h Plane.h NVDIMM.h Init.h P8PGCLogger.h P8PLogger.h GCLogger.h Logger.h GCFtl.h Ftl.h FlashTransaction.h FlashConfiguration.h Die.h Controller.h ChannelPacket.h Channel.h Callbacks.h Buffer.h Block.h --eval '(delete-other-windows)'&
+emacs Util.h TraceBasedSim.h SweepSim.h TraceDriver.h TraceReader.h ThreadedNVDIMM.h SimObj.h Plane.h LatencyHistogram.h NVDIMM.h Init.h P8PGCLogger.h P8PLogger.h GCLogger.h Logger.h EventLog.h LockFreeQueue.h ObjectPool.h GCFtl.h Ftl.h Checkpoint.h CompletionRing.h HostInterface.h MappingTable.h PageBitmap.h FlashTransaction.h FlashConfiguration.h Die.h Controller.h ChannelPacket.h Channel.h Callbacks.h Buffer.h Block.h --eval '(delete-other-windows)'&
 
 echo opening files
@@ -51,13 +51,14 @@ namespace NVDSim
 	void save(uint64_t cycle, uint epoch);
 	void print(uint64_t cycle);
 
-	void update();
+	void settle_idle_energy(void);
 
-	void access_stop(uint64_t addr, uint64_t paddr);
+	void access_stop(uint64_t id);
 
 	//Accessors for power data
 	//Writing correct object oriented code up in this piece, what now?
 	std::vector<std::vector<double>> getEnergyData(void);
+	const std::vector<double> *getEnergyField(PowerField field);
 
 	void save_epoch(uint64_t cycle, uint epoch);
 
@@ -70,6 +71,9 @@ namespace NVDSim
 	class EpochEntry
 	{
 	public:
+	    // not a SimObj itself, so this hides the logger's config_params() and sizes the entry from the current Config
+	    static const Config *config_params(void) { return NVDSim::config_params(); }
+
 	    uint64_t cycle;
 	    uint64_t epoch;
 
@@ -92,6 +96,8 @@ namespace NVDSim
 
 	    uint64_t ftl_queue_length;
 	    std::vector<uint64_t> ctrl_queue_length;
+	    uint64_t ftl_queue_integral;
+	    std::vector<uint64_t> ctrl_queue_integral;
 
 	    std::unordered_map<uint64_t, uint64_t> writes_per_address;
 
@@ -101,6 +107,8 @@ namespace NVDSim
 	    std::vector<double> vpp_idle_energy;
 	    std::vector<double> vpp_access_energy;
 
+	    std::vector<LatencyHistogram> latency_histograms;
+
 	    EpochEntry()
 	    {
 		num_accesses = 0;
@@ -122,6 +130,8 @@ namespace NVDSim
 		
 		ftl_queue_length = 0;
 		ctrl_queue_length = std::vector<uint64_t>(NUM_PACKAGES, 0);
+		ftl_queue_integral = 0;
+		ctrl_queue_integral = std::vector<uint64_t>(NUM_PACKAGES, 0);
 
 		idle_energy = std::vector<double>(NUM_PACKAGES, 0.0); 
 		access_energy = std::vector<double>(NUM_PACKAGES, 0.0); 
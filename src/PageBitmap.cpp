@@ -0,0 +1,125 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//PageBitmap.cpp
+//class file for a packed bitmap with one bit per page
+//
+#include "PageBitmap.h"
+#include <string.h>
+
+using namespace NVDSim;
+using namespace std;
+
+PageBitmap::PageBitmap(void){
+	pages_per_block = 0;
+	words_per_block = 0;
+}
+
+PageBitmap::PageBitmap(uint64_t blocks, uint64_t pages_per_block){
+	this->pages_per_block = pages_per_block;
+	words_per_block = (pages_per_block + 63) / 64;
+
+	bits = vector<uint64_t>(blocks * words_per_block, 0);
+	counts = vector<uint32_t>(blocks, 0);
+}
+
+void PageBitmap::set(uint64_t block, uint64_t page){
+	uint64_t &w = bits[block * words_per_block + (page >> 6)];
+	uint64_t mask = (uint64_t) 1 << (page & 63);
+
+	if (!(w & mask))
+	{
+		w |= mask;
+		counts[block]++;
+	}
+}
+
+void PageBitmap::clear(uint64_t block, uint64_t page){
+	uint64_t &w = bits[block * words_per_block + (page >> 6)];
+	uint64_t mask = (uint64_t) 1 << (page & 63);
+
+	if (w & mask)
+	{
+		w &= ~mask;
+		counts[block]--;
+	}
+}
+
+void PageBitmap::clear_block(uint64_t block){
+	uint64_t i;
+
+	for (i = 0; i < words_per_block; i++)
+		bits[block * words_per_block + i] = 0;
+	counts[block] = 0;
+}
+
+void PageBitmap::load(const uint64_t *words){
+	uint64_t block, i, count;
+	uint64_t last_mask = (pages_per_block & 63) ? ((uint64_t) 1 << (pages_per_block & 63)) - 1 : ~(uint64_t) 0;
+
+	memcpy(bits.data(), words, bits.size() * sizeof(uint64_t));
+	for (block = 0; block < counts.size(); block++)
+	{
+		// keep the bits past the end of the block clear no matter what was in the file
+		bits[block * words_per_block + words_per_block - 1] &= last_mask;
+
+		count = 0;
+		for (i = 0; i < words_per_block; i++)
+			count += __builtin_popcountll(bits[block * words_per_block + i]);
+		counts[block] = count;
+	}
+}
+
+// returns the first page at or after start whose bit is clear, or pages_per_block if there isn't one
+uint64_t PageBitmap::first_clear(uint64_t block, uint64_t start) const{
+	uint64_t w, free_bits, page;
+
+	if (start >= pages_per_block)
+		return pages_per_block;
+
+	w = start >> 6;
+	free_bits = ~bits[block * words_per_block + w] & (~(uint64_t) 0 << (start & 63));
+	while (true)
+	{
+		if (free_bits != 0)
+		{
+			page = (w << 6) + __builtin_ctzll(free_bits);
+			return page < pages_per_block ? page : pages_per_block;
+		}
+
+		w++;
+		if (w >= words_per_block)
+			return pages_per_block;
+		free_bits = ~bits[block * words_per_block + w];
+	}
+}
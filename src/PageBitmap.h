@@ -0,0 +1,81 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVPAGEBITMAP_H
+#define NVPAGEBITMAP_H
+//PageBitmap.h
+//header file for a packed bitmap with one bit per page
+
+#include <vector>
+#include <stdint.h>
+
+namespace NVDSim{
+	// One bit for every page on the device, packed 64 pages to a word. Each block starts on a new word so
+	// whole blocks can be searched and cleared a word at a time. The number of set bits in each block is
+	// kept alongside the bits.
+	class PageBitmap{
+		public:
+			PageBitmap(void);
+			PageBitmap(uint64_t blocks, uint64_t pages_per_block);
+
+			bool get(uint64_t block, uint64_t page) const
+			{
+				return (bits[block * words_per_block + (page >> 6)] >> (page & 63)) & 1;
+			}
+			void set(uint64_t block, uint64_t page);
+			void clear(uint64_t block, uint64_t page);
+			void clear_block(uint64_t block);
+
+			uint64_t count(uint64_t block) const { return counts[block]; }
+			uint64_t first_clear(uint64_t block, uint64_t start) const;
+
+			// raw access to the words of a block for combining bitmaps, bits past the end of the block are always 0
+			uint64_t word(uint64_t block, uint64_t w) const { return bits[block * words_per_block + w]; }
+			uint64_t words(void) const { return words_per_block; }
+
+			uint64_t blocks(void) const { return counts.size(); }
+			uint64_t pages(void) const { return pages_per_block; }
+
+			// all of the words at once for checkpoints, load() replaces them and recounts the blocks
+			const uint64_t *data(void) const { return bits.data(); }
+			uint64_t data_words(void) const { return bits.size(); }
+			void load(const uint64_t *words);
+
+		private:
+			uint64_t pages_per_block;
+			uint64_t words_per_block;
+			std::vector<uint64_t> bits;
+			std::vector<uint32_t> counts;
+	};
+}
+#endif
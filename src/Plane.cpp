@@ -63,8 +63,7 @@ void Plane::write(ChannelPacket *busPacket){
 
 	blocks[busPacket->block].write(busPacket->page, dataReg->data);
 
-	// The data packet is now done being used, so it can be deleted.
-	delete dataReg;
+	// The data packet is now done being used, the die gives it back to the pool.
 }
 
 // should only ever erase blocks
@@ -76,6 +75,25 @@ void Plane::erase(ChannelPacket *busPacket){
 }
 
 
+// writes every page whose bit is set in pages at once, used when restoring a checkpoint
+void Plane::populate(uint block, const uint64_t *pages, uint64_t words){
+	uint64_t w, bits;
+
+	if (blocks.find(block) == blocks.end())
+		blocks[block] = Block(block);
+
+	Block &b = blocks[block];
+	for (w = 0; w < words; w++)
+	{
+		bits = pages[w];
+		while (bits != 0)
+		{
+			b.write((w << 6) + __builtin_ctzll(bits), NULL);
+			bits &= bits - 1;
+		}
+	}
+}
+
 void Plane::storeInData(ChannelPacket *busPacket){
 	dataReg= busPacket;
 }
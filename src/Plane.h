@@ -47,6 +47,7 @@ namespace NVDSim{
 			void read(ChannelPacket *busPacket);
 			void write(ChannelPacket *busPacket);
 			void erase(ChannelPacket *busPacket);
+			void populate(uint block, const uint64_t *pages, uint64_t words);
 			void storeInData(ChannelPacket *busPacket); 
 			ChannelPacket *readFromData(void);
 		private:
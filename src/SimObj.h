@@ -45,14 +45,25 @@
 
 namespace NVDSim
 {
+	class Config;
+	extern thread_local const Config *current_config;
+
 	class SimObj
 	{
 	public:
 		uint64_t currentClockCycle;
 		
-		SimObj() { currentClockCycle = 0; };
+		SimObj() { currentClockCycle = 0; params = current_config; };
+		virtual ~SimObj() {};
 		void step();
 		virtual void update()=0;
+
+		// the parameter macros in FlashConfiguration.h find this before the global config_params() so
+		// the code in a SimObj reads the Config it was built under straight from the object
+		const Config *config_params(void) const { return params; }
+
+	protected:
+		const Config *params;
 	};
 }
 
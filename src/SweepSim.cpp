@@ -0,0 +1,355 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+/*SweepSim.cpp
+ *
+ * Runs one trace on every point of a grid of ini parameters in one process instead of a
+ * process (and a generated ini file) for each point like the scripts in tools/sweep_scripts:
+ *
+ *    ./NVDSweep -d <base ini> -t <trace> -g <KEY=values> [-g <KEY=values> ...] [-w <warm up trace>]
+ *               [-c <max cycles>] [-j <threads>] [-o <results file>]
+ *
+ * The values for a key are either a list, NUM_PACKAGES=1,2,4,8, or a range, DIES_PER_PACKAGE=1:8:*2
+ * or WRITE_TIME=100:400:100, and every combination of the values of all of the keys is a point.
+ * The trace and the warm up trace are read in once and shared by all of the points. Each point
+ * gets its own log directory and save file, named like the base ones with _point<n> and .point<n>
+ * on the end.
+ *
+ * The results go to the results file (sweep.tsv by default) as a tab separated table with a row
+ * for each point, see TraceDriver::printResults for the columns.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "SweepSim.h"
+#include "TraceDriver.h"
+#include "Init.h"
+
+namespace NVDSim
+{
+	// the points would all be printing over each other
+	uint OUTPUT= 0;
+}
+
+using namespace NVDSim;
+using namespace std;
+
+ParameterSweep::ParameterSweep(string ini) :
+	base_init(&base)
+{
+	base_init.ReadIniFile(ini, false);
+
+	trace = NULL;
+	warmup = NULL;
+	max_cycles = 0;
+	next_point = 0;
+}
+
+void ParameterSweep::addAxis(string spec){
+	size_t equals = spec.find('=');
+	string key, list, item;
+	vector<string> axis;
+	Config scratch;
+	Init init(&scratch);
+
+	if (equals == string::npos || equals == 0 || equals == spec.length() - 1)
+	{
+		ERROR("Sweep parameter '" << spec << "' should look like KEY=values");
+		exit(-1);
+	}
+	key = spec.substr(0, equals);
+	list = spec.substr(equals + 1);
+	if (!init.HasKey(key))
+	{
+		ERROR("Can't sweep '" << key << "', it isn't an ini parameter");
+		exit(-1);
+	}
+
+	if (list.find(':') == string::npos)
+	{
+		istringstream items(list);
+		while (getline(items, item, ','))
+		{
+			axis.push_back(item);
+		}
+	}
+	else
+	{
+		// first:last[:step]
+		double first, last, step = 1, value;
+		bool multiply = false;
+		size_t colon = list.find(':'), colon2 = list.find(':', colon + 1);
+		char *end;
+
+		first = strtod(list.c_str(), &end);
+		last = strtod(list.c_str() + colon + 1, &end);
+		if (colon2 != string::npos)
+		{
+			multiply = list[colon2 + 1] == '*';
+			step = strtod(list.c_str() + colon2 + 1 + multiply, &end);
+		}
+		if ((multiply && (step <= 1 || first <= 0)) || (!multiply && step <= 0) || last < first)
+		{
+			ERROR("Bad range '" << list << "' for " << key);
+			exit(-1);
+		}
+
+		for (value = first; value <= last * (1 + 1e-9); value = multiply ? value * step : value + step)
+		{
+			ostringstream out;
+			out << setprecision(15) << value;
+			axis.push_back(out.str());
+		}
+	}
+
+	if (axis.empty())
+	{
+		ERROR("No values to sweep for " << key);
+		exit(-1);
+	}
+	keys.push_back(key);
+	values.push_back(axis);
+}
+
+uint64_t ParameterSweep::points(void){
+	uint64_t i, count = 1;
+
+	for (i = 0; i < values.size(); i++)
+	{
+		count *= values[i].size();
+	}
+	return count;
+}
+
+// the last key changes the fastest
+vector<string> ParameterSweep::pointValues(uint64_t point){
+	vector<string> point_values(keys.size());
+	uint64_t i;
+
+	for (i = keys.size(); i > 0; i--)
+	{
+		point_values[i-1] = values[i-1][point % values[i-1].size()];
+		point /= values[i-1].size();
+	}
+	return point_values;
+}
+
+void ParameterSweep::run(const vector<TraceRequest> &trace, const vector<TraceRequest> &warmup, uint64_t max_cycles, uint threads){
+	vector<thread> pool;
+	uint i;
+
+	this->trace = &trace;
+	this->warmup = &warmup;
+	this->max_cycles = max_cycles;
+
+	results = vector<string>(points());
+	next_point = 0;
+	if (threads > results.size())
+	{
+		threads = results.size();
+	}
+	for (i = 0; i < threads; i++)
+	{
+		pool.push_back(thread(&ParameterSweep::worker, this));
+	}
+	for (i = 0; i < pool.size(); i++)
+	{
+		pool[i].join();
+	}
+}
+
+void ParameterSweep::worker(void){
+	uint64_t point;
+
+	while ((point = next_point++) < results.size())
+	{
+		runPoint(point);
+	}
+}
+
+void ParameterSweep::runPoint(uint64_t point){
+	vector<string> point_values = pointValues(point);
+	struct timespec start_time, end_time;
+	ostringstream row;
+	uint64_t i;
+	Config config = base;
+	Init init(&config);
+
+	init.CopySetKeys(base_init);
+	init.OverrideKeys(keys, point_values);
+	if (!init.CheckIfAllSet())
+	{
+		ERROR("Point " << point << " of the sweep is missing parameters");
+		exit(-1);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	NVDIMM *nvdimm = new NVDIMM(point, config);
+	nvdimm->tagOutputFiles("point" + to_string(point));
+	MemoryTraceReader reader(*trace);
+	TraceDriver driver(nvdimm, &reader);
+	if (!warmup->empty())
+	{
+		MemoryTraceReader warmup_reader(*warmup);
+		driver.fastForward(&warmup_reader);
+	}
+	driver.run(max_cycles);
+	nvdimm->saveStats();
+
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+	row << point;
+	for (i = 0; i < point_values.size(); i++)
+	{
+		row << "\t" << point_values[i];
+	}
+	row << "\t";
+	driver.printResults(row);
+	row << "\t" << (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) * 1e-9;
+	results[point] = row.str();
+
+	delete nvdimm;
+}
+
+void ParameterSweep::printResults(ostream &out){
+	uint64_t i;
+
+	out << "point";
+	for (i = 0; i < keys.size(); i++)
+	{
+		out << "\t" << keys[i];
+	}
+	out << "\t";
+	TraceDriver::printResultsHeader(out);
+	out << "\twall_seconds\n";
+
+	for (i = 0; i < results.size(); i++)
+	{
+		out << results[i] << "\n";
+	}
+}
+
+static void readTrace(string filename, vector<TraceRequest> &requests){
+	TraceReader *reader = TraceReader::open(filename);
+	TraceRequest request;
+
+	while (reader->next(request))
+	{
+		requests.push_back(request);
+	}
+	delete reader;
+}
+
+void usage(char *name){
+	cout << "usage: " << name << " -d <base ini> -t <trace file> -g <KEY=v1,v2,...|KEY=first:last[:step]> [-g ...] [-w <warm up trace>] [-c <max cycles>] [-j <threads>] [-o <results file>]\n";
+	exit(-1);
+}
+
+int main(int argc, char **argv){
+	string device_ini = "", trace_file = "", warmup_file = "", results_file = "sweep.tsv";
+	vector<string> axes;
+	vector<TraceRequest> trace, warmup;
+	uint64_t max_cycles = 0, i;
+	uint threads = thread::hardware_concurrency();
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:t:g:w:c:j:o:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd':
+				device_ini = optarg;
+				break;
+			case 't':
+				trace_file = optarg;
+				break;
+			case 'g':
+				axes.push_back(optarg);
+				break;
+			case 'w':
+				warmup_file = optarg;
+				break;
+			case 'c':
+				max_cycles = strtoull(optarg, NULL, 0);
+				break;
+			case 'j':
+				threads = strtoul(optarg, NULL, 0);
+				break;
+			case 'o':
+				results_file = optarg;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if (device_ini == "" || trace_file == "" || axes.empty())
+	{
+		usage(argv[0]);
+	}
+	if (threads == 0)
+	{
+		threads = 1;
+	}
+
+	ParameterSweep sweep(device_ini);
+	for (i = 0; i < axes.size(); i++)
+	{
+		sweep.addAxis(axes[i]);
+	}
+
+	readTrace(trace_file, trace);
+	if (warmup_file != "")
+	{
+		readTrace(warmup_file, warmup);
+	}
+
+	cout << "Running " << sweep.points() << " points on " << threads << " threads\n";
+	sweep.run(trace, warmup, max_cycles, threads);
+
+	ofstream out(results_file.c_str());
+	if (!out)
+	{
+		ERROR("Could not open results file " << results_file);
+		exit(-1);
+	}
+	sweep.printResults(out);
+	cout << "Wrote the results to " << results_file << "\n";
+
+	return 0;
+}
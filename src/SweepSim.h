@@ -0,0 +1,83 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVSWEEPSIM_H
+#define NVSWEEPSIM_H
+//SweepSim.h
+//header file for running a trace on every point of a grid of ini parameters
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include "TraceReader.h"
+#include "FlashConfiguration.h"
+#include "Init.h"
+
+namespace NVDSim{
+	// A parameter sweep. Every point of the grid is the base ini file with one value for each of the
+	// swept keys put in through Init::OverrideKeys, and gets its own NVDIMM. The points are run on a
+	// pool of threads and all of them play the same trace. The trace and the base ini are only read in once.
+	class ParameterSweep{
+		public:
+			ParameterSweep(std::string ini);
+
+			// KEY=v1,v2,... or KEY=first:last[:step], a step of *n multiplies by n instead of adding
+			void addAxis(std::string spec);
+			uint64_t points(void);
+
+			void run(const std::vector<TraceRequest> &trace, const std::vector<TraceRequest> &warmup, uint64_t max_cycles, uint threads);
+
+			// one tab separated row per point in grid order with a header line first
+			void printResults(std::ostream &out);
+
+		private:
+			void worker(void);
+			void runPoint(uint64_t point);
+			std::vector<std::string> pointValues(uint64_t point);
+
+			// the base ini as it was read, each point starts from a copy of it
+			Config base;
+			Init base_init;
+			std::vector<std::string> keys;
+			std::vector<std::vector<std::string> > values;
+
+			const std::vector<TraceRequest> *trace;
+			const std::vector<TraceRequest> *warmup;
+			uint64_t max_cycles;
+
+			std::atomic<uint64_t> next_point;
+			std::vector<std::string> results;
+	};
+}
+#endif
@@ -0,0 +1,240 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//ThreadedNVDIMM.cpp
+//class file for running an NVDIMM on its own thread beside the host
+
+#include "ThreadedNVDIMM.h"
+
+using namespace NVDSim;
+using namespace std;
+
+ThreadedNVDIMM::ThreadedNVDIMM(NVDIMM *nvdimm, uint64_t queue_entries, uint64_t lookahead) :
+	submissions(queue_entries),
+	completions(queue_entries)
+{
+	this->nvdimm = nvdimm;
+	this->lookahead = lookahead;
+
+	// the device thread moves completions from the NVDIMM's ring to ours every time it runs the
+	// device so the NVDIMM's ring only has to hold what one call can finish
+	drained_size = queue_entries;
+	drained = new Completion[drained_size];
+	nvdimm->EnableCompletionRing(queue_entries);
+
+	host_cycle = nvdimm->currentClockCycle;
+	device_cycle = nvdimm->currentClockCycle;
+	stopping = false;
+	stopped = false;
+	device_thread = thread(&ThreadedNVDIMM::run, this);
+}
+
+ThreadedNVDIMM::~ThreadedNVDIMM(void)
+{
+	stop();
+	delete [] drained;
+}
+
+bool ThreadedNVDIMM::submit(bool isWrite, uint64_t addr, uint64_t tag)
+{
+	Submission s;
+	s.address = addr;
+	s.tag = tag;
+	s.cycle = host_cycle.load(memory_order_relaxed);
+	s.isWrite = isWrite;
+	return submissions.push(s);
+}
+
+uint64_t ThreadedNVDIMM::poll(Completion *out, uint64_t max)
+{
+	uint64_t n = 0;
+	while (n < max && completions.pop(out[n]))
+	{
+		n++;
+	}
+	// once the device thread is gone whatever it couldn't hand over is ours
+	if (stopped.load(memory_order_acquire))
+	{
+		while (n < max && !backlog.empty())
+		{
+			out[n] = backlog.front();
+			backlog.pop_front();
+			n++;
+		}
+	}
+	return n;
+}
+
+// the host is done with everything before cycle, anything it submitted before this is already queued
+void ThreadedNVDIMM::advance(uint64_t cycle)
+{
+	host_cycle.store(cycle, memory_order_release);
+}
+
+// wait for the device to catch up with the host
+void ThreadedNVDIMM::sync(void)
+{
+	uint64_t spins = 0;
+	while (deviceCycle() < host_cycle.load(memory_order_relaxed) && !stopping)
+	{
+		if (++spins > 1000)
+		{
+			this_thread::yield();
+		}
+	}
+}
+
+void ThreadedNVDIMM::stop(void)
+{
+	if (device_thread.joinable())
+	{
+		stopping = true;
+		device_thread.join();
+	}
+}
+
+bool ThreadedNVDIMM::issue(const Submission &s)
+{
+	uint64_t id;
+	if (!nvdimm->addTransaction(s.isWrite, s.address, &id))
+	{
+		return false;
+	}
+	tags[id] = s.tag;
+	return true;
+}
+
+void ThreadedNVDIMM::returnCompletions(void)
+{
+	uint64_t i, n;
+	unordered_map<uint64_t, uint64_t>::iterator it;
+
+	// the older ones go first
+	while (!backlog.empty() && completions.push(backlog.front()))
+	{
+		backlog.pop_front();
+	}
+
+	while ((n = nvdimm->drainCompletions(drained, drained_size)) > 0)
+	{
+		for (i = 0; i < n; i++)
+		{
+			it = tags.find(drained[i].id);
+			if (it == tags.end())
+			{
+				ERROR("Completion for request "<<drained[i].id<<" that was never submitted");
+				abort();
+			}
+			drained[i].id = it->second;
+			// the critical line comes back before the rest of the read
+			if (drained[i].type != CRIT_LINE_COMPLETION)
+			{
+				tags.erase(it);
+			}
+
+			if (!backlog.empty() || !completions.push(drained[i]))
+			{
+				backlog.push_back(drained[i]);
+			}
+		}
+	}
+}
+
+void ThreadedNVDIMM::run(void)
+{
+	uint64_t now, limit, stop_at, target, next, spins = 0;
+	Submission pending;
+	bool have_pending = false, blocked;
+
+	while (!stopping)
+	{
+		now = nvdimm->currentClockCycle;
+		limit = host_cycle.load(memory_order_acquire) + lookahead;
+
+		// give the device everything that was submitted for this cycle or earlier
+		while (true)
+		{
+			if (!have_pending)
+			{
+				have_pending = submissions.pop(pending);
+				if (!have_pending)
+				{
+					break;
+				}
+			}
+			if (pending.cycle > now || !issue(pending))
+			{
+				break;
+			}
+			have_pending = false;
+		}
+
+		// while a request is being turned away nothing the host submits can get in ahead of it, so
+		// the device can keep going past the host until it is taken, the host may be waiting on that
+		blocked = have_pending && pending.cycle <= now;
+		if (now >= limit && !blocked)
+		{
+			// nothing to do until the host moves on
+			returnCompletions();
+			if (++spins > 1000)
+			{
+				this_thread::yield();
+			}
+			continue;
+		}
+		spins = 0;
+
+		// skip ahead over idle cycles, but not past a request that is waiting to go in
+		stop_at = limit;
+		if (blocked)
+		{
+			stop_at = now + 1;
+		}
+		else if (have_pending && pending.cycle < limit)
+		{
+			stop_at = pending.cycle;
+		}
+		next = nvdimm->nextEvent();
+		target = (next > stop_at - now) ? stop_at : now + next;
+		if (target == now)
+		{
+			target = now + 1;
+		}
+		nvdimm->advanceTo(target);
+
+		returnCompletions();
+		device_cycle.store(nvdimm->currentClockCycle, memory_order_release);
+	}
+
+	stopped.store(true, memory_order_release);
+}
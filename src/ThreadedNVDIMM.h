@@ -0,0 +1,112 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVTHREADEDNVDIMM_H
+#define NVTHREADEDNVDIMM_H
+//ThreadedNVDIMM.h
+//header file for running an NVDIMM on its own thread beside the host
+
+#include "NVDIMM.h"
+#include "LockFreeQueue.h"
+
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <deque>
+
+namespace NVDSim{
+	// Runs an NVDIMM on a thread of its own so a multithreaded host can keep simulating while the
+	// device does. Requests go to the device and completions come back through lock free queues.
+	//
+	// The host tells us how far it has got with advance(cycle), meaning it is done with every cycle
+	// before that one, and the device is allowed to run up to lookahead cycles past that. A request is
+	// given to the device on the cycle the host submitted it, or as soon as the device gets back to it
+	// if the device is already past it. So with a lookahead of 0 the device sees exactly what it would
+	// see if the host called add and update itself, and a bigger lookahead trades some timing accuracy
+	// for more overlap between the host and the device.
+	//
+	// Requests the device turns away are held and retried every cycle, in order, so submit only fails
+	// when the submission queue is full. The device doesn't wait for the host while it is holding a
+	// request so a full queue always drains. Completions are never dropped, if the host falls behind
+	// they wait on the device's side. A completion's id is the tag the request was submitted with.
+	// Once this is running nothing else should touch the NVDIMM until stop() is called, after that the
+	// completions still waiting can be polled from one thread.
+	class ThreadedNVDIMM{
+		public:
+			ThreadedNVDIMM(NVDIMM *nvdimm, uint64_t queue_entries, uint64_t lookahead);
+			~ThreadedNVDIMM(void);
+
+			// these can be called from any host thread
+			bool submit(bool isWrite, uint64_t addr, uint64_t tag);
+			uint64_t poll(Completion *out, uint64_t max);
+
+			// these should only be called by the thread that drives the host's clock
+			void advance(uint64_t cycle);
+			void sync(void);
+			void stop(void);
+
+			uint64_t deviceCycle(void) { return device_cycle.load(std::memory_order_acquire); }
+
+		private:
+			struct Submission
+			{
+				uint64_t address;
+				uint64_t tag;
+				uint64_t cycle;
+				bool isWrite;
+			};
+
+			void run(void);
+			bool issue(const Submission &s);
+			void returnCompletions(void);
+
+			NVDIMM *nvdimm;
+			uint64_t lookahead;
+
+			LockFreeQueue<Submission> submissions;
+			LockFreeQueue<Completion> completions;
+
+			std::atomic<uint64_t> host_cycle;
+			std::atomic<uint64_t> device_cycle;
+			std::atomic<bool> stopping;
+			std::atomic<bool> stopped;
+			std::thread device_thread;
+
+			// only touched by the device thread
+			std::unordered_map<uint64_t, uint64_t> tags; // request id -> host tag
+			Completion *drained;
+			uint64_t drained_size;
+			std::deque<Completion> backlog; // completions that didn't fit in the queue yet
+	};
+}
+#endif
@@ -33,10 +33,25 @@
 
 /*TraceBasedSim.cpp
  *
- * This will eventually run traces. Right now the name is a little misleading...
- * It adds a certain amount (NUM_WRITES) of write transactions to the flash dimm
- * linearly starting at address 0 and then simulates a certain number (SIM_CYCLES)
- * of cycles before exiting.
+ * Run with a trace file it plays the trace through the flash dimm (see TraceDriver.h and
+ * TraceReader.h for the details and the trace formats):
+ *
+ *    ./NVDSim -t <trace> [-d <device ini>] [-s <system ini>] [-c <max cycles>] [-w <warm up trace>]
+ *    ./NVDSim -t <text trace> -b <binary trace>     (converts a text trace to the binary format)
+ *    ./NVDSim -t <trace> -p <period> -u <unit> [-a <warm up cycles>] [-j <samples at once>]     (sampled simulation)
+ *
+ * A warm up trace is fast forwarded before the timed trace starts, its writes fill in the
+ * address map and the gc state without simulating any cycles.
+ *
+ * A sampled simulation fast forwards period requests at a time and between each of them runs the
+ * requests in the next unit cycles of the trace in detail in a forked copy of the simulator. The copy
+ * first runs the warm up cycles before the window in detail (unit cycles by default) so the window
+ * starts with the NVDIMM busy. Up to the number of cores samples run at the same time. The latency
+ * and throughput are then estimated from the samples.
+ *
+ * Run without any arguments it adds a certain amount (NUM_WRITES) of write transactions
+ * to the flash dimm linearly starting at address 0 and then simulates a certain number
+ * (SIM_CYCLES) of cycles before exiting.
  *
  * The output should be fairly straightforward. If you would like to see the writes
  * as they take place, change OUTPUT= 0; to OUTPUT= 1;
@@ -45,7 +60,11 @@
 #include "FlashConfiguration.h"
 #include "FlashTransaction.h"
 #include <time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <thread>
 #include "TraceBasedSim.h"
+#include "TraceDriver.h"
 
 #define NUM_WRITES 5000
 #define SIM_CYCLES 10000000
@@ -79,9 +98,100 @@ namespace NVDSim
 using namespace NVDSim;
 using namespace std;
 
-int main(void){
-	test_obj t;
-	t.run_test();
+void usage(char *name){
+	cout << "usage: " << name << " [-t <trace file> [-d <device ini>] [-s <system ini>] [-c <max cycles>] [-w <warm up trace>] [-p <sample period> -u <sample unit> [-a <sample warm up>] [-j <samples at once>]] [-b <binary trace to write>]]\n";
+	exit(-1);
+}
+
+int main(int argc, char **argv){
+	string trace_file = "", binary_file = "", warmup_file = "";
+	string device_ini = "ini/samsung_K9XXG08UXM_gc_test.ini", system_ini = "ini/def_system.ini";
+	uint64_t max_cycles = 0, period = 0, unit = 0, warm = 0;
+	bool have_warm = false;
+	uint jobs = thread::hardware_concurrency();
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:d:s:c:w:p:u:a:j:b:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't':
+				trace_file = optarg;
+				break;
+			case 'd':
+				device_ini = optarg;
+				break;
+			case 's':
+				system_ini = optarg;
+				break;
+			case 'c':
+				max_cycles = strtoull(optarg, NULL, 0);
+				break;
+			case 'w':
+				warmup_file = optarg;
+				break;
+			case 'p':
+				period = strtoull(optarg, NULL, 0);
+				break;
+			case 'u':
+				unit = strtoull(optarg, NULL, 0);
+				break;
+			case 'a':
+				warm = strtoull(optarg, NULL, 0);
+				have_warm = true;
+				break;
+			case 'j':
+				jobs = strtoul(optarg, NULL, 0);
+				break;
+			case 'b':
+				binary_file = optarg;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	// no trace, just do the old write test
+	if (trace_file == "")
+	{
+		test_obj t;
+		t.run_test();
+		return 0;
+	}
+
+	TraceReader *trace = TraceReader::open(trace_file);
+	if (binary_file != "")
+	{
+		uint64_t count = BinaryTraceReader::convert(trace, binary_file);
+		cout << "Wrote " << count << " requests to " << binary_file << "\n";
+		delete trace;
+		return 0;
+	}
+
+	NVDIMM *NVDimm= new NVDIMM(1, device_ini, system_ini, "", "");
+	TraceDriver driver(NVDimm, trace);
+	if (warmup_file != "")
+	{
+		TraceReader *warmup = TraceReader::open(warmup_file);
+		uint64_t count = driver.fastForward(warmup);
+		cout << "Fast forwarded " << count << " requests from " << warmup_file << "\n";
+		delete warmup;
+	}
+	if (period != 0 && unit != 0)
+	{
+		driver.runSampled(period, unit, have_warm ? warm : unit, jobs > 0 ? jobs : 1);
+	}
+	else
+	{
+		driver.run(max_cycles);
+	}
+
+	driver.printStats();
+	NVDimm->printStats();
+	NVDimm->saveStats();
+
+	delete trace;
+	delete NVDimm;
 	return 0;
 }
 
@@ -176,6 +286,13 @@ void test_obj::run_test(void){
 		  }
 	      }
 	  }
+	  else
+	  {
+	      // nothing left to add so let the NVDIMM skip over the cycles where it has nothing to do
+	      (*NVDimm).advanceTo(SIM_CYCLES);
+	      cycle = (*NVDimm).currentClockCycle;
+	      break;
+	  }
 
 		(*NVDimm).update();
 		/*if (cycle < NUM_WRITES){
@@ -0,0 +1,467 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//TraceDriver.cpp
+//class file for running a trace file through an NVDIMM
+//
+#include "TraceDriver.h"
+#include <time.h>
+#include <math.h>
+#include <sys/wait.h>
+
+using namespace NVDSim;
+using namespace std;
+
+TraceDriver::TraceDriver(NVDIMM *nv, TraceReader *trace){
+	nvdimm = nv;
+	reader = trace;
+
+	outstanding = 0;
+	issued_reads = 0;
+	issued_writes = 0;
+	unmapped_reads = 0;
+	stall_cycles = 0;
+	last_completion = 0;
+	end_cycle = 0;
+	wall_seconds = 0;
+	ff_requests = 0;
+
+	// outside of a sample everything is measured
+	measure_start = 0;
+	measure_end = (uint64_t) -1;
+	window_completions = 0;
+
+	read_done = new Callback<TraceDriver, void, uint, uint64_t, uint64_t, bool>(this, &TraceDriver::read_cb);
+	write_done = new Callback<TraceDriver, void, uint, uint64_t, uint64_t, bool>(this, &TraceDriver::write_cb);
+	nvdimm->RegisterTaggedCallbacks(read_done, NULL, write_done);
+}
+
+TraceDriver::~TraceDriver(void){
+	delete read_done;
+	delete write_done;
+}
+
+uint64_t TraceDriver::fastForward(TraceReader *warmup){
+	TraceRequest request;
+	uint64_t count = 0;
+
+	while (warmup->next(request))
+	{
+		nvdimm->addFfTransaction(request.write, request.address);
+		count++;
+	}
+
+	return count;
+}
+
+void TraceDriver::run(uint64_t max_cycles){
+	TraceRequest request;
+	FlashTransaction trans;
+	uint64_t now, next;
+	bool have_request;
+	clock_t start = clock();
+
+	have_request = reader->next(request);
+	while (true)
+	{
+		now = nvdimm->currentClockCycle;
+		if (max_cycles != 0 && now >= max_cycles)
+		{
+			break;
+		}
+
+		if (have_request)
+		{
+			if (request.cycle <= now)
+			{
+				// issue everything that is due this cycle until the NVDIMM pushes back
+				trans = FlashTransaction(request.write ? DATA_WRITE : DATA_READ, request.address, (void *)0xdeadbeef);
+				if (nvdimm->add(trans))
+				{
+					pending[trans.id] = PendingRequest(now, request.cycle >= measure_start);
+					if (request.write)
+					{
+						issued_writes++;
+					}
+					else
+					{
+						issued_reads++;
+					}
+					outstanding++;
+
+					have_request = reader->next(request);
+					continue;
+				}
+				stall_cycles++;
+			}
+			else
+			{
+				// nothing is due until the next request so skip ahead to it
+				next = request.cycle;
+				if (max_cycles != 0 && next > max_cycles)
+				{
+					next = max_cycles;
+				}
+				nvdimm->advanceTo(next);
+				continue;
+			}
+		}
+		else
+		{
+			// the trace is done, wait for whatever is still in flight
+			if (outstanding == 0 || now - last_completion > TRACE_DRAIN_TIMEOUT)
+			{
+				break;
+			}
+
+			next = nvdimm->nextEvent();
+			if (next == NO_EVENT)
+			{
+				break;
+			}
+			if (next > 0)
+			{
+				nvdimm->advanceTo(now + next);
+				continue;
+			}
+		}
+
+		nvdimm->update();
+	}
+
+	end_cycle = nvdimm->currentClockCycle;
+	wall_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	if (outstanding != 0)
+	{
+		WARNING(outstanding << " requests were still outstanding when the trace driver stopped");
+	}
+}
+
+void TraceDriver::runSampled(uint64_t period, uint64_t unit, uint64_t warm, uint jobs){
+	TraceRequest request;
+	vector<TraceRequest> requests;
+	uint64_t i, window_start;
+	bool have_request;
+	struct timespec start_time, end_time;
+
+	// the samples run in other processes so this is wall clock time rather than cpu time
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	have_request = reader->next(request);
+	while (have_request)
+	{
+		for (i = 0; i < period && have_request; i++)
+		{
+			nvdimm->addFfTransaction(request.write, request.address);
+			ff_requests++;
+			have_request = reader->next(request);
+		}
+		if (!have_request)
+		{
+			break;
+		}
+
+		// everything in the next warm + unit cycles of the trace is simulated in detail by a copy
+		requests.clear();
+		window_start = request.cycle + warm;
+		while (have_request && request.cycle < window_start + unit)
+		{
+			requests.push_back(request);
+			have_request = reader->next(request);
+		}
+
+		// a window cut short by the end of the trace would make the throughput look lower than it is
+		if (have_request)
+		{
+			while (running.size() >= jobs)
+			{
+				finishSample();
+			}
+			startSample(requests, window_start, unit);
+		}
+
+		// and the state moves forward over the same requests here while it runs
+		for (i = 0; i < requests.size(); i++)
+		{
+			nvdimm->addFfTransaction(requests[i].write, requests[i].address);
+			ff_requests++;
+		}
+	}
+
+	while (!running.empty())
+	{
+		finishSample();
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+	wall_seconds = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) * 1e-9;
+}
+
+void TraceDriver::startSample(vector<TraceRequest> &requests, uint64_t window_start, uint64_t unit){
+	RunningSample sample;
+	SampleResult result;
+	uint64_t i, start, first;
+	int fds[2];
+	ssize_t got;
+
+	if (pipe(fds) != 0)
+	{
+		ERROR("Could not make a pipe for a sample");
+		abort();
+	}
+
+	sample.pid = nvdimm->forkSimulation("sample" + to_string(samples.size()));
+	if (sample.pid == 0)
+	{
+		close(fds[0]);
+
+		// the requests start now as far as the copy is concerned
+		start = nvdimm->currentClockCycle;
+		first = requests[0].cycle;
+		for (i = 0; i < requests.size(); i++)
+		{
+			requests[i].cycle = requests[i].cycle - first + start;
+		}
+		measure_start = window_start - first + start;
+		measure_end = measure_start + unit;
+		read_latency = LatencyStats();
+		write_latency = LatencyStats();
+		window_completions = 0;
+
+		MemoryTraceReader memory(requests);
+		reader = &memory;
+		run(0);
+
+		// the requests in the window are run until they finish for their latencies but the
+		// cycles spent draining them aren't part of the window
+		result.cycles = unit;
+		result.completed = window_completions;
+		result.reads = read_latency.count;
+		result.writes = write_latency.count;
+		result.read_total = read_latency.total;
+		result.write_total = write_latency.total;
+		// the result is smaller than the pipe buffer so this doesn't wait for the parent to read it
+		got = write(fds[1], &result, sizeof(result));
+		cout.flush();
+		_exit(got == sizeof(result) ? 0 : 1);
+	}
+
+	close(fds[1]);
+	sample.fd = fds[0];
+	sample.index = samples.size();
+	samples.push_back(SampleResult());
+	running.push_back(sample);
+}
+
+// waits for whichever running sample finishes first and collects its result
+void TraceDriver::finishSample(void){
+	SampleResult result;
+	uint64_t i;
+	int status;
+	ssize_t got;
+	pid_t pid;
+
+	while (true)
+	{
+		pid = waitpid(-1, &status, 0);
+		if (pid < 0)
+		{
+			ERROR("Lost track of " << running.size() << " running samples");
+			abort();
+		}
+
+		for (i = 0; i < running.size(); i++)
+		{
+			if (running[i].pid == pid)
+			{
+				break;
+			}
+		}
+		if (i < running.size())
+		{
+			break;
+		}
+	}
+
+	got = read(running[i].fd, &result, sizeof(result));
+	close(running[i].fd);
+
+	if (got != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		ERROR("Sample " << running[i].index << " did not finish");
+		abort();
+	}
+	samples[running[i].index] = result;
+	running.erase(running.begin() + i);
+}
+
+void TraceDriver::read_cb(uint id, uint64_t request, uint64_t cycle, bool mapped){
+	if (!mapped)
+	{
+		unmapped_reads++;
+	}
+	complete(read_latency, request);
+}
+
+void TraceDriver::write_cb(uint id, uint64_t request, uint64_t cycle, bool mapped){
+	complete(write_latency, request);
+}
+
+// the callbacks report the clock of whatever part of the NVDIMM finished the request which
+// isn't always the NVDIMM clock, so latency is measured against the NVDIMM clock instead
+void TraceDriver::complete(LatencyStats &stats, uint64_t request){
+	unordered_map<uint64_t, PendingRequest>::iterator it = pending.find(request);
+	if (it == pending.end())
+	{
+		WARNING("Trace driver got a callback for request " << request << " which it didn't issue");
+		return;
+	}
+
+	if ((*it).second.measured)
+	{
+		stats.add(nvdimm->currentClockCycle - (*it).second.issued);
+	}
+	pending.erase(it);
+
+	if (nvdimm->currentClockCycle >= measure_start && nvdimm->currentClockCycle < measure_end)
+	{
+		window_completions++;
+	}
+
+	outstanding--;
+	last_completion = nvdimm->currentClockCycle;
+}
+
+void TraceDriver::LatencyStats::add(uint64_t latency){
+	if (count == 0 || latency < min)
+	{
+		min = latency;
+	}
+	if (latency > max)
+	{
+		max = latency;
+	}
+	total += latency;
+	count++;
+}
+
+void TraceDriver::printStats(void){
+	uint64_t done = read_latency.count + write_latency.count;
+	double seconds = (double)end_cycle * CYCLE_TIME * 1e-9;
+
+	if (!samples.empty())
+	{
+		printSampleStats();
+		return;
+	}
+
+	cout << "Trace Driver Results:\n";
+	cout << "Cycles simulated: " << end_cycle << "\n";
+	cout << "Requests issued: " << issued_reads + issued_writes << " (" << issued_reads << " reads, " << issued_writes << " writes)\n";
+	cout << "Requests completed: " << done << " (" << read_latency.count << " reads, " << write_latency.count << " writes)\n";
+	cout << "Unmapped reads: " << unmapped_reads << "\n";
+	cout << "Cycles stalled on a full NVDIMM: " << stall_cycles << "\n";
+	if (end_cycle > 0)
+	{
+		cout << "Throughput: " << (double)done / end_cycle << " requests/cycle, " <<
+			((double)done * NV_PAGE_SIZE * 1024) / seconds / (1024 * 1024) << " MB/s\n";
+	}
+	if (read_latency.count > 0)
+	{
+		cout << "Read latency (cycles): average " << (double)read_latency.total / read_latency.count <<
+			" min " << read_latency.min << " max " << read_latency.max << "\n";
+	}
+	if (write_latency.count > 0)
+	{
+		cout << "Write latency (cycles): average " << (double)write_latency.total / write_latency.count <<
+			" min " << write_latency.min << " max " << write_latency.max << "\n";
+	}
+	cout << "Execution time: " << wall_seconds << " seconds";
+	if (wall_seconds > 0)
+	{
+		cout << ", " << (double)end_cycle / wall_seconds << " cycles/second";
+	}
+	cout << "\n";
+}
+
+void TraceDriver::printResultsHeader(ostream &out){
+	out << "cycles\tissued_reads\tissued_writes\treads\twrites\tunmapped_reads\tstall_cycles\terases\t" <<
+		"throughput\tread_latency\tread_min\tread_max\twrite_latency\twrite_min\twrite_max";
+}
+
+// averages are 0 when nothing of that kind finished
+void TraceDriver::printResults(ostream &out){
+	uint64_t done = read_latency.count + write_latency.count;
+
+	out << end_cycle << "\t" << issued_reads << "\t" << issued_writes << "\t" << read_latency.count << "\t" <<
+		write_latency.count << "\t" << unmapped_reads << "\t" << stall_cycles << "\t" << nvdimm->numErases << "\t" <<
+		(end_cycle ? (double)done / end_cycle : 0) << "\t" <<
+		(read_latency.count ? (double)read_latency.total / read_latency.count : 0) << "\t" <<
+		read_latency.min << "\t" << read_latency.max << "\t" <<
+		(write_latency.count ? (double)write_latency.total / write_latency.count : 0) << "\t" <<
+		write_latency.min << "\t" << write_latency.max;
+}
+
+// The estimates are the mean over the samples with a 95% confidence interval.
+void TraceDriver::printSampleStats(void){
+	uint64_t i, n = samples.size(), done = 0, reads = 0, writes = 0;
+	double latency, throughput, sum_l = 0, sq_l = 0, sum_t = 0, sq_t = 0, ci_l = 0, ci_t = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		done = samples[i].reads + samples[i].writes;
+		reads += samples[i].reads;
+		writes += samples[i].writes;
+
+		latency = done ? (double)(samples[i].read_total + samples[i].write_total) / done : 0;
+		throughput = samples[i].cycles ? (double)samples[i].completed / samples[i].cycles : 0;
+		sum_l += latency;
+		sq_l += latency * latency;
+		sum_t += throughput;
+		sq_t += throughput * throughput;
+	}
+
+	if (n > 1)
+	{
+		ci_l = 1.96 * sqrt(fmax(sq_l - sum_l * sum_l / n, 0) / (n - 1) / n);
+		ci_t = 1.96 * sqrt(fmax(sq_t - sum_t * sum_t / n, 0) / (n - 1) / n);
+	}
+
+	cout << "Sampled Trace Driver Results:\n";
+	cout << "Samples: " << n << " (" << reads << " reads, " << writes << " writes simulated in detail)\n";
+	cout << "Requests fast forwarded: " << ff_requests << "\n";
+	cout << "Average latency (cycles): " << sum_l / n << " +/- " << ci_l << "\n";
+	cout << "Throughput: " << sum_t / n << " +/- " << ci_t << " requests/cycle\n";
+	cout << "Execution time: " << wall_seconds << " seconds\n";
+}
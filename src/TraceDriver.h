@@ -0,0 +1,159 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVTRACEDRIVER_H
+#define NVTRACEDRIVER_H
+//TraceDriver.h
+//header file for running a trace file through an NVDIMM
+
+#include <vector>
+#include <unordered_map>
+#include "NVDIMM.h"
+#include "TraceReader.h"
+
+// if nothing finishes for this many cycles after the trace is done we stop waiting
+#define TRACE_DRAIN_TIMEOUT 10000000
+
+namespace NVDSim{
+	// Issues the requests in a trace at their cycles. If the NVDIMM won't take a request it is retried
+	// every cycle until it does and the requests behind it wait. Cycles where nothing is due and the
+	// NVDIMM has nothing to do are skipped. The only per request state kept is for requests that are in
+	// flight so memory use doesn't depend on the length of the trace.
+	class TraceDriver{
+		public:
+			TraceDriver(NVDIMM *nv, TraceReader *trace);
+			// the NVDIMM still has the callbacks registered so it mustn't be updated after this
+			~TraceDriver(void);
+
+			// plays a warm up trace through the fast forward path, the cycles in it are ignored
+			// returns the number of requests that were fast forwarded
+			uint64_t fastForward(TraceReader *warmup);
+
+			// runs the trace and then waits for the outstanding requests, 0 means no cycle limit
+			void run(uint64_t max_cycles);
+
+			// Sampled simulation like SMARTS. The trace is fast forwarded and after every period requests
+			// a copy of the simulator is forked off to run the requests in the next warm + unit cycles of the
+			// trace in detail. The first warm cycles fill the queues and dies so the window that is measured
+			// starts with requests in flight, only the unit cycles of the window itself are counted. The copy
+			// sends back its results and exits while the same requests are fast forwarded here and the next
+			// period starts, up to jobs samples run at once.
+			void runSampled(uint64_t period, uint64_t unit, uint64_t warm, uint jobs);
+			void printStats(void);
+
+			// the results as one line of tab separated columns for tables of many runs, see SweepSim.cpp
+			static void printResultsHeader(std::ostream &out);
+			void printResults(std::ostream &out);
+
+			// registered as tagged callbacks so they get the id of the request that finished
+			void read_cb(uint id, uint64_t request, uint64_t cycle, bool mapped);
+			void write_cb(uint id, uint64_t request, uint64_t cycle, bool mapped);
+
+		private:
+			class LatencyStats{
+			public:
+				uint64_t count, total, min, max;
+
+				LatencyStats()
+				{
+					count = 0;
+					total = 0;
+					min = 0;
+					max = 0;
+				}
+
+				void add(uint64_t latency);
+			};
+
+			class PendingRequest{
+			public:
+				uint64_t issued; // cycle the request was issued
+				bool measured; // does its latency count?
+
+				PendingRequest()
+				{
+					issued = 0;
+					measured = false;
+				}
+
+				PendingRequest(uint64_t issued, bool measured)
+				{
+					this->issued = issued;
+					this->measured = measured;
+				}
+			};
+
+			// what a sample sends back to the parent
+			class SampleResult{
+			public:
+				// completed is what finished in the cycles of the window, the latencies are for the
+				// requests issued in it
+				uint64_t cycles, completed, reads, writes, read_total, write_total;
+			};
+
+			// a sample that has been forked off and hasn't been collected yet
+			class RunningSample{
+			public:
+				pid_t pid;
+				int fd; // the copy writes its SampleResult here
+				uint64_t index; // where it goes in samples
+			};
+
+			void complete(LatencyStats &stats, uint64_t request);
+			void startSample(std::vector<TraceRequest> &requests, uint64_t window_start, uint64_t unit);
+			void finishSample(void);
+			void printSampleStats(void);
+
+			NVDIMM *nvdimm;
+			Callback_t *read_done, *write_done;
+			TraceReader *reader;
+
+			// the requests in flight by request id
+			std::unordered_map<uint64_t, PendingRequest> pending;
+			uint64_t outstanding;
+
+			uint64_t issued_reads, issued_writes, unmapped_reads;
+			uint64_t stall_cycles, last_completion, end_cycle;
+			LatencyStats read_latency, write_latency;
+			double wall_seconds;
+
+			// requests from the trace before measure_start only warm the NVDIMM up so their latencies
+			// aren't counted, window_completions counts what finishes from measure_start to measure_end
+			uint64_t measure_start, measure_end, window_completions;
+
+			std::vector<SampleResult> samples;
+			std::vector<RunningSample> running;
+			uint64_t ff_requests;
+	};
+}
+#endif
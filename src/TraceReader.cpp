@@ -0,0 +1,243 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//TraceReader.cpp
+//class file for the trace file readers used by the trace driver
+//
+#include "TraceReader.h"
+#include "FlashConfiguration.h"
+#include <string.h>
+#include <stdlib.h>
+
+using namespace NVDSim;
+using namespace std;
+
+// how many records the binary reader pulls in at a time
+#define BINARY_TRACE_CHUNK 65536
+// size of the stdio buffer for text traces
+#define TEXT_TRACE_BUFFER (1 << 20)
+
+TraceReader::TraceReader(void){
+	file = NULL;
+}
+
+TraceReader::~TraceReader(void){
+	if (file != NULL)
+	{
+		fclose(file);
+	}
+}
+
+TraceReader *TraceReader::open(string filename){
+	char magic[8];
+	size_t got;
+
+	FILE *f = fopen(filename.c_str(), "rb");
+	if (f == NULL)
+	{
+		ERROR("Could not open trace file " << filename);
+		exit(-1);
+	}
+	got = fread(magic, 1, 8, f);
+	fclose(f);
+
+	if (got == 8 && memcmp(magic, BINARY_TRACE_MAGIC, 8) == 0)
+	{
+		return new BinaryTraceReader(filename);
+	}
+	return new TextTraceReader(filename);
+}
+
+TextTraceReader::TextTraceReader(string filename){
+	this->filename = filename;
+	line_number = 0;
+
+	file = fopen(filename.c_str(), "r");
+	if (file == NULL)
+	{
+		ERROR("Could not open trace file " << filename);
+		exit(-1);
+	}
+	file_buffer = vector<char>(TEXT_TRACE_BUFFER);
+	setvbuf(file, &file_buffer[0], _IOFBF, file_buffer.size());
+}
+
+bool TextTraceReader::next(TraceRequest &request){
+	char line[1024];
+	char first[256], second[256], third[256];
+	int fields;
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		line_number++;
+
+		fields = sscanf(line, "%255s %255s %255s", first, second, third);
+		if (fields <= 0 || first[0] == '#')
+		{
+			continue;
+		}
+		if (fields != 3)
+		{
+			ERROR("Malformed line " << line_number << " in trace file " << filename);
+			exit(-1);
+		}
+
+		// HybridSim style has a number in the middle, DRAMSim style has a command name
+		if (second[0] >= '0' && second[0] <= '9')
+		{
+			request.cycle = strtoull(first, NULL, 0);
+			request.write = (strtoull(second, NULL, 0) != 0);
+			request.address = strtoull(third, NULL, 0);
+		}
+		else
+		{
+			request.address = strtoull(first, NULL, 0);
+			if (strcmp(second, "WRITE") == 0 || strcmp(second, "P_MEM_WR") == 0 || strcmp(second, "P_LOCK_WR") == 0)
+			{
+				request.write = true;
+			}
+			else if (strcmp(second, "READ") == 0 || strcmp(second, "P_MEM_RD") == 0 || strcmp(second, "P_LOCK_RD") == 0 ||
+				 strcmp(second, "P_FETCH") == 0 || strcmp(second, "IFETCH") == 0)
+			{
+				request.write = false;
+			}
+			else
+			{
+				ERROR("Unknown command " << second << " on line " << line_number << " in trace file " << filename);
+				exit(-1);
+			}
+			request.cycle = strtoull(third, NULL, 0);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+BinaryTraceReader::BinaryTraceReader(string filename){
+	char magic[8];
+	uint32_t version, record_size;
+
+	this->filename = filename;
+	record = 0;
+	num_records = 0;
+
+	file = fopen(filename.c_str(), "rb");
+	if (file == NULL)
+	{
+		ERROR("Could not open trace file " << filename);
+		exit(-1);
+	}
+
+	if (fread(magic, 1, 8, file) != 8 || memcmp(magic, BINARY_TRACE_MAGIC, 8) != 0 ||
+	    fread(&version, sizeof(version), 1, file) != 1 || fread(&record_size, sizeof(record_size), 1, file) != 1)
+	{
+		ERROR("Trace file " << filename << " does not have a binary trace header");
+		exit(-1);
+	}
+	if (version != BINARY_TRACE_VERSION || record_size != 2 * sizeof(uint64_t))
+	{
+		ERROR("Trace file " << filename << " is binary trace version " << version << " with " << record_size <<
+		      " byte records, only version " << BINARY_TRACE_VERSION << " with 16 byte records is supported");
+		exit(-1);
+	}
+
+	records = vector<uint64_t>(2 * BINARY_TRACE_CHUNK);
+}
+
+bool BinaryTraceReader::next(TraceRequest &request){
+	if (record == num_records)
+	{
+		num_records = fread(&records[0], 2 * sizeof(uint64_t), BINARY_TRACE_CHUNK, file);
+		record = 0;
+		if (num_records == 0)
+		{
+			return false;
+		}
+	}
+
+	request.cycle = records[2 * record];
+	request.address = records[2 * record + 1] & ~BINARY_TRACE_WRITE;
+	request.write = (records[2 * record + 1] & BINARY_TRACE_WRITE) != 0;
+	record++;
+	return true;
+}
+
+MemoryTraceReader::MemoryTraceReader(const vector<TraceRequest> &requests) :
+	requests(requests)
+{
+	position = 0;
+}
+
+bool MemoryTraceReader::next(TraceRequest &request){
+	if (position == requests.size())
+	{
+		return false;
+	}
+
+	request = requests[position];
+	position++;
+	return true;
+}
+
+uint64_t BinaryTraceReader::convert(TraceReader *in, string filename){
+	TraceRequest request;
+	uint64_t count = 0;
+	uint32_t version = BINARY_TRACE_VERSION, record_size = 2 * sizeof(uint64_t);
+	uint64_t rec[2];
+
+	FILE *out = fopen(filename.c_str(), "wb");
+	if (out == NULL)
+	{
+		ERROR("Could not open binary trace file " << filename);
+		exit(-1);
+	}
+
+	fwrite(BINARY_TRACE_MAGIC, 1, 8, out);
+	fwrite(&version, sizeof(version), 1, out);
+	fwrite(&record_size, sizeof(record_size), 1, out);
+	while (in->next(request))
+	{
+		rec[0] = request.cycle;
+		rec[1] = request.address | (request.write ? BINARY_TRACE_WRITE : 0);
+		fwrite(rec, sizeof(rec), 1, out);
+		count++;
+	}
+
+	if (fclose(out) != 0)
+	{
+		ERROR("Could not finish writing binary trace file " << filename);
+		exit(-1);
+	}
+	return count;
+}
@@ -0,0 +1,125 @@
+/*********************************************************************************
+*  Copyright (c) 2011-2012, Paul Tschirhart
+*                             Peter Enns
+*                             Jim Stevens
+*                             Ishwar Bhati
+*                             Mu-Tien Chang
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             pkt3c [at] umd [dot] edu
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef NVTRACEREADER_H
+#define NVTRACEREADER_H
+//TraceReader.h
+//header file for the trace file readers used by the trace driver
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+// binary traces start with this, followed by a 32 bit version and a 32 bit record size
+#define BINARY_TRACE_MAGIC "NVDTRACE"
+#define BINARY_TRACE_VERSION 1
+// top bit of the address field in a binary record marks a write
+#define BINARY_TRACE_WRITE ((uint64_t) 1 << 63)
+
+namespace NVDSim{
+	class TraceRequest{
+		public:
+			uint64_t cycle;
+			uint64_t address;
+			bool write;
+
+			TraceRequest()
+			{
+				cycle = 0;
+				address = 0;
+				write = false;
+			}
+	};
+
+	// Reads a trace one request at a time through a fixed size buffer so traces of any size can be
+	// run without holding them in memory.
+	class TraceReader{
+		public:
+			TraceReader(void);
+			virtual ~TraceReader(void);
+
+			// fills in the next request, returns false once the trace is done
+			virtual bool next(TraceRequest &request) = 0;
+
+			// opens either kind of trace, binary traces are recognized by their header
+			static TraceReader *open(std::string filename);
+
+		protected:
+			FILE *file;
+			std::string filename;
+	};
+
+	// Text traces have one request per line in either of these layouts:
+	//    <address> <command> <cycle>    like DRAMSim, e.g. 0x7f64768 P_MEM_WR 4 or 0x1000 READ 10
+	//    <cycle> <type> <address>       like HybridSim, where type is 0 for a read and 1 for a write
+	// Addresses may be hex (with 0x) or decimal. Blank lines and lines starting with # are skipped.
+	class TextTraceReader : public TraceReader{
+		public:
+			TextTraceReader(std::string filename);
+			bool next(TraceRequest &request);
+
+		private:
+			std::vector<char> file_buffer;
+			uint64_t line_number;
+	};
+
+	// Binary traces are the header followed by 16 byte records: the cycle and then the address,
+	// both 64 bits in host byte order, with BINARY_TRACE_WRITE or'd into the address for writes.
+	class BinaryTraceReader : public TraceReader{
+		public:
+			BinaryTraceReader(std::string filename);
+			bool next(TraceRequest &request);
+
+			// writes everything left in a trace out as a binary trace, returns the number of requests written
+			static uint64_t convert(TraceReader *in, std::string filename);
+
+		private:
+			std::vector<uint64_t> records;
+			uint64_t record, num_records;
+	};
+
+	// Plays back requests that have already been read in. The sampled runs use this so a forked copy
+	// of the simulator never reads from the trace file it shares with its parent, and the points of a
+	// sweep all play the same requests. The requests aren't copied so they have to outlive the reader.
+	class MemoryTraceReader : public TraceReader{
+		public:
+			MemoryTraceReader(const std::vector<TraceRequest> &requests);
+			bool next(TraceRequest &request);
+
+		private:
+			const std::vector<TraceRequest> &requests;
+			uint64_t position;
+	};
+}
+#endif